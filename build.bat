@@ -20,8 +20,30 @@ if errorlevel 1 (
     exit /b 1
 )
 
+make -f Build.make mapconv
+
+if errorlevel 1 (
+    echo Failed to build map converter
+    exit /b 1
+)
+
+cd ..
+
+echo Building load test bot...
+
+cd gamebot
+
+make -f Build.make building
+
+if errorlevel 1 (
+    echo Failed to build load test bot
+    exit /b 1
+)
+
 cd ..
 
 echo Build completed successfully!
 echo Client executable: gameclient/build/game.exe
-echo Server executable: gameserver/build/server.exe 
+echo Server executable: gameserver/build/server.exe
+echo Map converter: gameserver/build/mapconv.exe
+echo Load test bot: gamebot/build/bot.exe
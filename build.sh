@@ -11,11 +11,23 @@ cd gameserver
 
 make -f Build.make building
 
+make -f Build.make mapconv
+
+cd ..
+
+echo Building load test bot...
+
+cd gamebot
+
+make -f Build.make building
+
 cd ..
 
 echo Build completed successfully!
 
 echo Client executable: gameclient/build/game
 echo Server executable: gameserver/build/server
+echo Map converter: gameserver/build/mapconv
+echo Load test bot: gamebot/build/bot
 
 ./gameclient/build/game && ./gameserver/build/server
@@ -0,0 +1,217 @@
+#include "chunk_codec.h"
+#include <string.h>
+
+static int varint_size(uint32_t value) {
+  int size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+// Bits needed to index a palette of the given size; a single entry needs none
+static int palette_bits(int count) {
+  int bits = 0;
+  while ((1 << bits) < count) {
+    bits++;
+  }
+  return bits;
+}
+
+static int rle_size(const unsigned char *tile_ids) {
+  int size = 0;
+  for (int i = 0; i < CHUNK_TILE_COUNT;) {
+    int run = 1;
+    while (i + run < CHUNK_TILE_COUNT && tile_ids[i + run] == tile_ids[i]) {
+      run++;
+    }
+    size += varint_size(run) + 1;
+    i += run;
+  }
+  return size;
+}
+
+static void write_rle(WireWriter *w, const unsigned char *tile_ids) {
+  for (int i = 0; i < CHUNK_TILE_COUNT;) {
+    int run = 1;
+    while (i + run < CHUNK_TILE_COUNT && tile_ids[i + run] == tile_ids[i]) {
+      run++;
+    }
+    wire_write_varint(w, run);
+    wire_write_u8(w, tile_ids[i]);
+    i += run;
+  }
+}
+
+static bool read_rle(WireReader *r, unsigned char *tile_ids) {
+  int filled = 0;
+  while (filled < CHUNK_TILE_COUNT) {
+    uint32_t run = wire_read_varint(r);
+    unsigned char tile_id = wire_read_u8(r);
+    if (r->overflow || run == 0 || run > (uint32_t)(CHUNK_TILE_COUNT - filled)) {
+      return false;
+    }
+    memset(tile_ids + filled, tile_id, run);
+    filled += run;
+  }
+  return true;
+}
+
+static void write_palette(WireWriter *w, const unsigned char *tile_ids,
+                          const unsigned char *palette, int count,
+                          const short *palette_index) {
+  int bits = palette_bits(count);
+  wire_write_varint(w, count);
+  wire_write_bytes(w, palette, count);
+
+  // Pack indices least significant bit first
+  uint32_t accumulator = 0;
+  int pending = 0;
+  for (int i = 0; i < CHUNK_TILE_COUNT && bits > 0; i++) {
+    accumulator |= (uint32_t)palette_index[tile_ids[i]] << pending;
+    pending += bits;
+    while (pending >= 8) {
+      wire_write_u8(w, (uint8_t)accumulator);
+      accumulator >>= 8;
+      pending -= 8;
+    }
+  }
+  if (pending > 0) {
+    wire_write_u8(w, (uint8_t)accumulator);
+  }
+}
+
+static bool read_palette(WireReader *r, unsigned char *tile_ids) {
+  unsigned char palette[256];
+  uint32_t count = wire_read_varint(r);
+  if (count == 0 || count > 256) {
+    return false;
+  }
+  wire_read_bytes(r, palette, count);
+
+  int bits = palette_bits(count);
+  uint32_t accumulator = 0;
+  int pending = 0;
+  for (int i = 0; i < CHUNK_TILE_COUNT; i++) {
+    uint32_t index = 0;
+    if (bits > 0) {
+      while (pending < bits) {
+        accumulator |= (uint32_t)wire_read_u8(r) << pending;
+        pending += 8;
+      }
+      index = accumulator & ((1u << bits) - 1);
+      accumulator >>= bits;
+      pending -= bits;
+    }
+    if (index >= count) {
+      return false;
+    }
+    tile_ids[i] = palette[index];
+  }
+  return !r->overflow;
+}
+
+// Encode a chunk's tile ids with whichever encoding comes out smallest
+void chunk_encode(WireWriter *w, const unsigned char *tile_ids) {
+  unsigned char palette[256];
+  short palette_index[256];
+  int count = 0;
+
+  for (int i = 0; i < 256; i++) {
+    palette_index[i] = -1;
+  }
+  for (int i = 0; i < CHUNK_TILE_COUNT; i++) {
+    if (palette_index[tile_ids[i]] < 0) {
+      palette_index[tile_ids[i]] = count;
+      palette[count++] = tile_ids[i];
+    }
+  }
+
+  int raw = CHUNK_TILE_COUNT;
+  int rle = rle_size(tile_ids);
+  int packed = varint_size(count) + count + (CHUNK_TILE_COUNT * palette_bits(count) + 7) / 8;
+
+  if (packed <= rle && packed < raw) {
+    wire_write_u8(w, CHUNK_ENCODING_PALETTE);
+    write_palette(w, tile_ids, palette, count, palette_index);
+  } else if (rle < raw) {
+    wire_write_u8(w, CHUNK_ENCODING_RLE);
+    write_rle(w, tile_ids);
+  } else {
+    wire_write_u8(w, CHUNK_ENCODING_RAW);
+    wire_write_bytes(w, tile_ids, CHUNK_TILE_COUNT);
+  }
+}
+
+// Decode a chunk payload written by chunk_encode()
+bool chunk_decode(WireReader *r, unsigned char *tile_ids) {
+  switch (wire_read_u8(r)) {
+  case CHUNK_ENCODING_RAW:
+    wire_read_bytes(r, tile_ids, CHUNK_TILE_COUNT);
+    return !r->overflow;
+  case CHUNK_ENCODING_RLE:
+    return read_rle(r, tile_ids);
+  case CHUNK_ENCODING_PALETTE:
+    return read_palette(r, tile_ids);
+  default:
+    return false;
+  }
+}
+
+// Write a complete PKT_TILE_CHUNK packet
+void tile_chunk_write_packet(WireWriter *w, int chunk_x, int chunk_y, uint32_t version,
+                             const unsigned char *tile_ids) {
+  wire_write_u8(w, PKT_TILE_CHUNK);
+  wire_write_u16(w, chunk_x);
+  wire_write_u16(w, chunk_y);
+  wire_write_u32(w, version);
+  wire_write_u8(w, CHUNK_SIZE);
+  chunk_encode(w, tile_ids);
+}
+
+// Read a PKT_TILE_CHUNK packet; fails if it was built for another chunk size
+bool tile_chunk_read_packet(WireReader *r, int *chunk_x, int *chunk_y, uint32_t *version,
+                            unsigned char *tile_ids) {
+  wire_read_u8(r); // Packet type
+  *chunk_x = wire_read_u16(r);
+  *chunk_y = wire_read_u16(r);
+  *version = wire_read_u32(r);
+  if (wire_read_u8(r) != CHUNK_SIZE || r->overflow) {
+    return false;
+  }
+  return chunk_decode(r, tile_ids);
+}
+
+// Write a PKT_TILE_DELTA packet with the tiles of one chunk that changed
+void tile_delta_write_packet(WireWriter *w, int chunk_x, int chunk_y, uint32_t version,
+                             const TileChange *changes, int count) {
+  wire_write_u8(w, PKT_TILE_DELTA);
+  wire_write_u16(w, chunk_x);
+  wire_write_u16(w, chunk_y);
+  wire_write_u32(w, version);
+  wire_write_varint(w, count);
+  for (int i = 0; i < count; i++) {
+    wire_write_u8(w, changes[i].index);
+    wire_write_u8(w, changes[i].tile_id);
+  }
+}
+
+// Read a PKT_TILE_DELTA packet; changes must have room for CHUNK_TILE_COUNT entries
+bool tile_delta_read_packet(WireReader *r, int *chunk_x, int *chunk_y, uint32_t *version,
+                            TileChange *changes, int *count) {
+  wire_read_u8(r); // Packet type
+  *chunk_x = wire_read_u16(r);
+  *chunk_y = wire_read_u16(r);
+  *version = wire_read_u32(r);
+  uint32_t change_count = wire_read_varint(r);
+  if (r->overflow || change_count > CHUNK_TILE_COUNT) {
+    return false;
+  }
+  for (uint32_t i = 0; i < change_count; i++) {
+    changes[i].index = wire_read_u8(r);
+    changes[i].tile_id = wire_read_u8(r);
+  }
+  *count = (int)change_count;
+  return !r->overflow;
+}
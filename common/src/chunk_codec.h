@@ -0,0 +1,44 @@
+#ifndef CHUNK_CODEC_H
+#define CHUNK_CODEC_H
+
+#include <stdbool.h>
+#include "common.h"
+#include "wire.h"
+
+#define CHUNK_TILE_COUNT (CHUNK_SIZE * CHUNK_SIZE)
+
+// Tile chunk payload encodings
+#define CHUNK_ENCODING_RAW 0     // One tile id per byte
+#define CHUNK_ENCODING_RLE 1     // (varint run length, tile id) pairs
+#define CHUNK_ENCODING_PALETTE 2 // Palette of ids plus bit-packed indices
+
+// PKT_TILE_CHUNK: type, chunk x and y (u16), chunk version (u32), chunk size (u8),
+// encoding (u8), payload
+#define TILE_CHUNK_HEADER_SIZE 11
+// The encoder never picks anything larger than the raw encoding
+#define TILE_CHUNK_MAX_PACKET_SIZE (TILE_CHUNK_HEADER_SIZE + CHUNK_TILE_COUNT)
+
+// PKT_TILE_DELTA: type, chunk x and y (u16), chunk version after the change (u32),
+// change count (varint), then a (tile index, tile id) byte pair per change
+#define TILE_DELTA_HEADER_SIZE (1 + 2 + 2 + 4 + VARINT_MAX_SIZE)
+#define TILE_DELTA_MAX_PACKET_SIZE (TILE_DELTA_HEADER_SIZE + 2 * CHUNK_TILE_COUNT)
+_Static_assert(CHUNK_TILE_COUNT <= 256, "tile delta indices are one byte");
+
+// One changed tile, indexed row-major inside its chunk
+typedef struct {
+  unsigned char index;
+  unsigned char tile_id;
+} TileChange;
+
+void chunk_encode(WireWriter *w, const unsigned char *tile_ids);
+bool chunk_decode(WireReader *r, unsigned char *tile_ids);
+void tile_chunk_write_packet(WireWriter *w, int chunk_x, int chunk_y, uint32_t version,
+                             const unsigned char *tile_ids);
+bool tile_chunk_read_packet(WireReader *r, int *chunk_x, int *chunk_y, uint32_t *version,
+                            unsigned char *tile_ids);
+void tile_delta_write_packet(WireWriter *w, int chunk_x, int chunk_y, uint32_t version,
+                             const TileChange *changes, int count);
+bool tile_delta_read_packet(WireReader *r, int *chunk_x, int *chunk_y, uint32_t *version,
+                            TileChange *changes, int *count);
+
+#endif // CHUNK_CODEC_H
@@ -13,29 +13,8 @@ void init_players(PlayerMap *map) {
     map->count = 0;
 }
 
-// Update player positions based on server data
-void update_player_positions(PlayerMap *map, const PlayerPositionsPacket *packet) {
-    for (int i = 0; i < packet->player_count; i++) {
-        int id = packet->players[i].id;
-        for (int j = 0; j < map->count; j++) {
-            if (map->players[id].id == id) {
-                map->players[id].x = packet->players[id].x;
-                map->players[id].y = packet->players[id].y;
-                break;
-            }
-        }
-    }
-    printf("Updated positions - Active players: ");
-    for (int i = 0; i < map->count; i++) {
-        if (map->players[i].active) {
-            printf("P%d(%d,%d) ", map->players[i].id, map->players[i].x, map->players[i].y);
-        }
-    }
-    printf("\n");
-}
-
 // Add a remote player
-void add_remote_player_id(PlayerMap *map, unsigned char player_id, unsigned char color_index) {
+void add_remote_player_id(PlayerMap *map, int player_id, unsigned char color_index) {
     int new_player_id = (int)player_id;
     for (int i = 0; i < map->count; i++) {
         if (map->players[i].id == new_player_id) {
@@ -53,7 +32,7 @@ void add_remote_player_id(PlayerMap *map, unsigned char player_id, unsigned char
 }
 
 // Remove a remote player
-void remove_remote_player_id(PlayerMap *map, unsigned char player_id) {
+void remove_remote_player_id(PlayerMap *map, int player_id) {
     int new_player_id = (int)player_id;
     for (int i = 0; i < map->count; i++) {
         if (map->players[i].id == new_player_id) {
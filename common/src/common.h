@@ -8,19 +8,38 @@
 // Common definitions
 #define VIEWPORT_WIDTH 20
 #define VIEWPORT_HEIGHT 15
-#define MAX_PLAYERS 32
+// Player capacity is set when the server starts; ids go on the wire as 16 bits
+#define DEFAULT_MAX_PLAYERS 32
+#define MAX_PLAYER_LIMIT ENET_PROTOCOL_MAXIMUM_PEER_ID
 #define TILE_SIZE 32
-#define CHUNK_SIZE 5
+#define CHUNK_SIZE 16
+// Chunks within this many chunks of a player are streamed to it; chunks
+// more than one chunk further away are unloaded again
+#define CHUNK_STREAM_RADIUS ((VIEWPORT_WIDTH / 2 + CHUNK_SIZE - 1) / CHUNK_SIZE + 1)
+// Side of the client's chunk cache, must hold a (2 * radius + 3) square
+#define CHUNK_CACHE_SIZE 16
+
+// Channel layout shared by client and server
+#define CHANNEL_RELIABLE 0 // Join/leave, ids and map data: reliable and ordered
+#define CHANNEL_STATE 1    // Snapshots, acks and input: unreliable, sequenced
+#define CHANNEL_COUNT 2
 
 // Common packet types
 #define PKT_TILE_CHUNK 0x01
-#define PKT_MOVE 0x02
-#define PKT_PLAYER_POSITIONS 0x03
 #define PKT_PLAYER_ID 0x04
 #define PKT_ADD_PLAYER 0x05
 #define PKT_REMOVE_PLAYER 0x06
+#define PKT_SNAPSHOT 0x07
+#define PKT_SNAPSHOT_ACK 0x08
+#define PKT_UNLOAD_CHUNK 0x09
+#define PKT_INPUT 0x0A
+#define PKT_STATS_REQUEST 0x0B
+#define PKT_SERVER_STATS 0x0C
+#define PKT_TILE_DELTA 0x0D
+#define PKT_CHUNK_REQUEST 0x0E
 
 // Common structures
+// walkable is derived from tile_id through the table in tiles.h
 typedef struct {
   unsigned char tile_id;
   unsigned char walkable;
@@ -28,32 +47,41 @@ typedef struct {
 
 typedef struct {
   unsigned char type;
-  unsigned char chunk_x;
-  unsigned char chunk_y;
-  Tile tiles[CHUNK_SIZE * CHUNK_SIZE];
-} TileChunkPacket;
+  uint16_t chunk_x;
+  uint16_t chunk_y;
+} ChunkUnloadPacket;
 
+// Sent by a client whose copy of a chunk fell out of step with the server
 typedef struct {
   unsigned char type;
-  signed char dir_x;
-  signed char dir_y;
-} MovePacket;
+  uint16_t chunk_x;
+  uint16_t chunk_y;
+} ChunkRequestPacket;
 
 typedef struct {
   unsigned char type;
-  unsigned char player_count;
-  struct {
-    unsigned char id;
-    signed char x;
-    signed char y;
-  } players[MAX_PLAYERS];
-} PlayerPositionsPacket;
+  unsigned char color_index;
+  uint16_t player_id;
+} PlayerIdPacket;
 
+// Sent on PKT_PLAYER_ID: the new player's id and the server settings the client needs
 typedef struct {
   unsigned char type;
-  unsigned char player_id;
   unsigned char color_index;
-} PlayerIdPacket;
+  uint16_t player_id;
+  uint16_t tick_rate;
+  uint16_t max_players;
+} WelcomePacket;
+
+// Entity kinds shared by client and server; each gets its own pool in the
+// criogenio entity world
+typedef enum EntityType {
+  ENTITY_PLAYER,
+  ENTITY_BULLET,
+  ENTITY_ENEMY,
+  ENTITY_ITEM,
+  ENTITY_TYPE_COUNT,
+} EntityType;
 
 // Base Player structure (common fields)
 typedef struct {
@@ -62,6 +90,9 @@ typedef struct {
   int id;
   unsigned char color_index;
   bool active;
+  bool in_view; // Inside the local player's area of interest (client only)
+  float draw_x; // Smoothed position in tiles used for drawing (client only)
+  float draw_y;
 } Player;
 
 // Common structures
@@ -70,15 +101,16 @@ typedef struct {
   Player player;
 } PeerPlayerEntry;
 
+// Players the client knows about; grows as players join
 typedef struct {
-  PeerPlayerEntry entries[MAX_PLAYERS];
+  PeerPlayerEntry *entries;
   int count;
+  int capacity;
 } PlayerMap;
 
 // Common player management functions
 void init_players(PlayerMap *map);
-void update_player_positions(PlayerMap *map, const PlayerPositionsPacket *packet);
-void add_remote_player_id(PlayerMap *map, unsigned char player_id, unsigned char color_index);
-void remove_remote_player_id(PlayerMap *map, unsigned char player_id);
+void add_remote_player_id(PlayerMap *map, int player_id, unsigned char color_index);
+void remove_remote_player_id(PlayerMap *map, int player_id);
 
 #endif // COMMON_H 
\ No newline at end of file
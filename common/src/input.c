@@ -0,0 +1,77 @@
+#include "input.h"
+#include <string.h>
+
+bool input_is_idle(const InputCommand *command) {
+  return command->dir_x == 0 && command->dir_y == 0;
+}
+
+void input_window_reset(InputWindow *window) {
+  window->count = 0;
+  window->next_sequence = 1;
+}
+
+// Record a new command with the next sequence number, dropping the oldest
+InputCommand input_window_push(InputWindow *window, int dir_x, int dir_y) {
+  InputCommand command = {window->next_sequence++, dir_x, dir_y};
+  if (window->count == INPUT_REDUNDANCY) {
+    memmove(window->commands, window->commands + 1, (INPUT_REDUNDANCY - 1) * sizeof(InputCommand));
+    window->count--;
+  }
+  window->commands[window->count++] = command;
+  return command;
+}
+
+// True when sending the window would tell the server nothing new
+bool input_window_is_idle(const InputWindow *window) {
+  for (int i = 0; i < window->count; i++) {
+    if (!input_is_idle(&window->commands[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Both directions fit in one byte, two bits each
+static uint8_t pack_directions(const InputCommand *command) {
+  return (uint8_t)((command->dir_x + 1) | (command->dir_y + 1) << 2);
+}
+
+static bool unpack_directions(uint8_t packed, InputCommand *command) {
+  int dir_x = (packed & 0x03) - 1;
+  int dir_y = (packed >> 2 & 0x03) - 1;
+  if (packed > 0x0F || dir_x > 1 || dir_y > 1) {
+    return false;
+  }
+  command->dir_x = dir_x;
+  command->dir_y = dir_y;
+  return true;
+}
+
+// Write a PKT_INPUT packet. commands holds consecutive sequences, oldest first;
+// they go on the wire newest first so only the newest sequence is needed.
+void input_write_packet(WireWriter *w, const InputCommand *commands, int count) {
+  wire_write_u8(w, PKT_INPUT);
+  wire_write_u32(w, commands[count - 1].sequence);
+  wire_write_u8(w, count);
+  for (int i = count - 1; i >= 0; i--) {
+    wire_write_u8(w, pack_directions(&commands[i]));
+  }
+}
+
+// Read a PKT_INPUT packet into commands, newest first.
+// Returns the number of commands, or -1 if the packet is malformed.
+int input_read_packet(WireReader *r, InputCommand *commands, int max_commands) {
+  wire_read_u8(r); // Packet type
+  uint32_t newest = wire_read_u32(r);
+  int count = wire_read_u8(r);
+  if (r->overflow || count == 0 || count > max_commands || newest < (uint32_t)count) {
+    return -1;
+  }
+  for (int i = 0; i < count; i++) {
+    commands[i].sequence = newest - i;
+    if (!unpack_directions(wire_read_u8(r), &commands[i])) {
+      return -1;
+    }
+  }
+  return r->overflow ? -1 : count;
+}
@@ -0,0 +1,41 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+#include "wire.h"
+
+// Input commands sampled per second until the welcome packet brings the
+// server's tick rate; from then on one command is sampled per server tick,
+// since the server applies at most one movement command per tick
+#define INPUT_RATE 20
+// Each input packet repeats this many of the newest commands, so a command
+// survives until that many packets in a row are lost
+#define INPUT_REDUNDANCY 8
+
+// Packet: type, newest sequence, command count, one byte per command
+#define INPUT_PACKET_MAX_SIZE (1 + 4 + 1 + INPUT_REDUNDANCY)
+
+// One sampled frame of player input
+typedef struct {
+  uint32_t sequence; // Starts at 1 and increases by one per command
+  int8_t dir_x;      // -1, 0 or 1
+  int8_t dir_y;
+} InputCommand;
+
+// Newest commands sent by a client, oldest first; each packet repeats them all
+typedef struct {
+  InputCommand commands[INPUT_REDUNDANCY];
+  int count;
+  uint32_t next_sequence;
+} InputWindow;
+
+bool input_is_idle(const InputCommand *command);
+void input_window_reset(InputWindow *window);
+InputCommand input_window_push(InputWindow *window, int dir_x, int dir_y);
+bool input_window_is_idle(const InputWindow *window);
+void input_write_packet(WireWriter *w, const InputCommand *commands, int count);
+int input_read_packet(WireReader *r, InputCommand *commands, int max_commands);
+
+#endif // INPUT_H
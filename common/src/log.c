@@ -0,0 +1,205 @@
+#include "log.h"
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// How long the writer sleeps when the ring is empty
+#define LOG_IDLE_SLEEP_MS 5
+
+typedef struct {
+  atomic_size_t sequence; // Slot state, see log_write() and log_drain()
+  int level;
+  uint32_t time_ms;
+  char message[LOG_MESSAGE_SIZE];
+} LogRecord;
+
+atomic_int log_runtime_level = LOG_LEVEL_INFO;
+
+static LogRecord ring[LOG_RING_SIZE];
+static atomic_size_t enqueue_pos;
+static size_t dequeue_pos; // Only touched by the writer thread
+static atomic_uint dropped;
+static atomic_bool writer_running;
+static pthread_t writer_thread;
+
+static const char *level_names[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+
+uint32_t log_time_ms(void) {
+#ifdef _WIN32
+  return (uint32_t)GetTickCount();
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint32_t)(now.tv_sec * 1000u + now.tv_nsec / 1000000);
+#endif
+}
+
+static void sleep_ms(unsigned ms) {
+#ifdef _WIN32
+  Sleep(ms);
+#else
+  usleep(ms * 1000);
+#endif
+}
+
+static void print_record(int level, uint32_t time_ms, const char *message) {
+  FILE *out = level >= LOG_LEVEL_WARN ? stderr : stdout;
+  fprintf(out, "[%u.%03u] %-5s %s\n", time_ms / 1000, time_ms % 1000, level_names[level], message);
+}
+
+// Print everything queued so far; returns the number of records written
+static int log_drain(void) {
+  int written = 0;
+  for (;;) {
+    LogRecord *record = &ring[dequeue_pos & (LOG_RING_SIZE - 1)];
+    size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+    if (sequence != dequeue_pos + 1) {
+      break; // Empty, or the producer has not finished this slot yet
+    }
+    print_record(record->level, record->time_ms, record->message);
+    atomic_store_explicit(&record->sequence, dequeue_pos + LOG_RING_SIZE, memory_order_release);
+    dequeue_pos++;
+    written++;
+  }
+
+  unsigned lost = atomic_exchange_explicit(&dropped, 0, memory_order_relaxed);
+  if (lost > 0) {
+    char message[64];
+    snprintf(message, sizeof(message), "Log ring full, dropped %u messages", lost);
+    print_record(LOG_LEVEL_WARN, log_time_ms(), message);
+  }
+  if (written > 0 || lost > 0) {
+    fflush(stdout);
+  }
+  return written;
+}
+
+static void *log_writer_main(void *arg) {
+  (void)arg;
+  while (atomic_load(&writer_running)) {
+    if (log_drain() == 0) {
+      sleep_ms(LOG_IDLE_SLEEP_MS);
+    }
+  }
+  log_drain();
+  return NULL;
+}
+
+// Start the writer thread. Until this is called messages are printed inline.
+// Queued messages are flushed at exit, so error paths can still exit().
+bool log_init(void) {
+  static bool registered = false;
+  for (size_t i = 0; i < LOG_RING_SIZE; i++) {
+    atomic_init(&ring[i].sequence, i);
+  }
+  atomic_store(&enqueue_pos, 0);
+  dequeue_pos = 0;
+  atomic_store(&writer_running, true);
+  if (pthread_create(&writer_thread, NULL, log_writer_main, NULL) != 0) {
+    atomic_store(&writer_running, false);
+    fprintf(stderr, "Failed to start log writer thread\n");
+    return false;
+  }
+  if (!registered) {
+    atexit(log_shutdown);
+    registered = true;
+  }
+  return true;
+}
+
+// Flush queued messages and stop the writer thread
+void log_shutdown(void) {
+  if (!atomic_load(&writer_running)) {
+    return;
+  }
+  atomic_store(&writer_running, false);
+  pthread_join(writer_thread, NULL);
+}
+
+void log_set_level(int level) {
+  atomic_store(&log_runtime_level, level);
+}
+
+// Level for a name such as "debug"; -1 if the name is unknown
+int log_parse_level(const char *name) {
+  for (int i = 0; i < LOG_LEVEL_OFF; i++) {
+    if (strcasecmp(name, level_names[i]) == 0) {
+      return i;
+    }
+  }
+  if (strcasecmp(name, "off") == 0) {
+    return LOG_LEVEL_OFF;
+  }
+  return -1;
+}
+
+// Format a message into the ring. Never blocks: when the writer falls behind
+// the message is dropped and counted instead.
+void log_write(int level, const char *format, ...) {
+  va_list args;
+  if (!atomic_load_explicit(&writer_running, memory_order_relaxed)) {
+    char message[LOG_MESSAGE_SIZE];
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    print_record(level, log_time_ms(), message);
+    return;
+  }
+
+  // Claim a slot (bounded MPSC queue, one sequence number per slot)
+  LogRecord *record;
+  size_t pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+  for (;;) {
+    record = &ring[pos & (LOG_RING_SIZE - 1)];
+    size_t sequence = atomic_load_explicit(&record->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&enqueue_pos, &pos, pos + 1,
+                                                memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+      return;
+    } else {
+      pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    }
+  }
+
+  record->level = level;
+  record->time_ms = log_time_ms();
+  va_start(args, format);
+  vsnprintf(record->message, sizeof(record->message), format, args);
+  va_end(args);
+  atomic_store_explicit(&record->sequence, pos + 1, memory_order_release);
+}
+
+// Decide whether a rate limited call site may log now. When a new window
+// starts, a note about the messages suppressed in the last one is logged.
+bool log_rate_allow(LogRateLimit *limit, int level, unsigned per_second) {
+  uint32_t now = log_time_ms();
+  unsigned start = atomic_load_explicit(&limit->window_start, memory_order_relaxed);
+  if (now - start >= 1000) {
+    if (atomic_compare_exchange_strong(&limit->window_start, &start, now)) {
+      atomic_store(&limit->count, 0);
+      unsigned suppressed = atomic_exchange(&limit->suppressed, 0);
+      if (suppressed > 0) {
+        log_write(level, "(suppressed %u similar messages)", suppressed);
+      }
+    }
+  }
+  if (atomic_fetch_add_explicit(&limit->count, 1, memory_order_relaxed) < per_second) {
+    return true;
+  }
+  atomic_fetch_add_explicit(&limit->suppressed, 1, memory_order_relaxed);
+  return false;
+}
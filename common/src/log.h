@@ -0,0 +1,73 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Log levels, lowest first
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_OFF 5
+
+// Calls below this level are removed by the compiler, arguments and all.
+// Override with -DLOG_COMPILE_LEVEL=LOG_LEVEL_TRACE for per-tile tracing.
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// Records queued for the writer thread; must be a power of two
+#define LOG_RING_SIZE 1024
+#define LOG_MESSAGE_SIZE 240
+
+// Runtime threshold, checked before any formatting happens
+extern atomic_int log_runtime_level;
+
+// Per call site state for rate limited messages
+typedef struct {
+  atomic_uint window_start; // Millisecond clock at the start of the window
+  atomic_uint count;        // Messages let through in this window
+  atomic_uint suppressed;   // Messages dropped in this window
+} LogRateLimit;
+
+#define LOG_ENABLED(level) \
+  ((level) >= LOG_COMPILE_LEVEL && (level) >= atomic_load_explicit(&log_runtime_level, memory_order_relaxed))
+
+#define LOG_AT(level, ...)           \
+  do {                               \
+    if (LOG_ENABLED(level)) {        \
+      log_write((level), __VA_ARGS__); \
+    }                                \
+  } while (0)
+
+// Let at most per_second messages a second through from this call site
+#define LOG_RATE_LIMITED(level, per_second, ...)                  \
+  do {                                                            \
+    static LogRateLimit log_limit_;                               \
+    if (LOG_ENABLED(level) && log_rate_allow(&log_limit_, (level), (per_second))) { \
+      log_write((level), __VA_ARGS__);                            \
+    }                                                             \
+  } while (0)
+
+#define LOG_TRACE(...) LOG_AT(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+bool log_init(void);
+void log_shutdown(void);
+void log_set_level(int level);
+int log_parse_level(const char *name);
+void log_write(int level, const char *format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+bool log_rate_allow(LogRateLimit *limit, int level, unsigned per_second);
+uint32_t log_time_ms(void);
+
+#endif // LOG_H
@@ -0,0 +1,134 @@
+#include "packet_pool.h"
+#include "log.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Header in front of every buffer; the payload follows it
+typedef struct PooledBuffer {
+  struct PooledBuffer *next; // Free list link while the buffer is pooled
+  int size_class;            // -1 for a one-off buffer larger than every class
+  size_t capacity;
+  _Alignas(16) uint8_t data[];
+} PooledBuffer;
+
+static const size_t class_sizes[PACKET_POOL_CLASS_COUNT] = {
+    PACKET_POOL_SMALL, PACKET_POOL_MEDIUM, PACKET_POOL_LARGE};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static PooledBuffer *free_lists[PACKET_POOL_CLASS_COUNT];
+static PacketPoolStats pool_stats;
+
+static PooledBuffer *header_of(const uint8_t *buffer) {
+  return (PooledBuffer *)(buffer - offsetof(PooledBuffer, data));
+}
+
+// Buffer with room for at least size bytes, NULL if out of memory.
+// Give it back with packet_pool_release() unless it goes into a packet.
+uint8_t *packet_pool_acquire(size_t size) {
+  int size_class = 0;
+  while (size_class < PACKET_POOL_CLASS_COUNT && class_sizes[size_class] < size) {
+    size_class++;
+  }
+
+  PooledBuffer *buffer = NULL;
+  pthread_mutex_lock(&pool_lock);
+  if (size_class < PACKET_POOL_CLASS_COUNT && free_lists[size_class]) {
+    buffer = free_lists[size_class];
+    free_lists[size_class] = buffer->next;
+  }
+  pool_stats.acquired++;
+  pool_stats.outstanding++;
+  pthread_mutex_unlock(&pool_lock);
+  if (buffer) {
+    return buffer->data;
+  }
+
+  // Pool empty for this class: grow it by one buffer
+  size_t capacity = size_class < PACKET_POOL_CLASS_COUNT ? class_sizes[size_class] : size;
+  buffer = malloc(sizeof(PooledBuffer) + capacity);
+  pthread_mutex_lock(&pool_lock);
+  if (buffer) {
+    pool_stats.allocated++;
+  } else {
+    pool_stats.outstanding--;
+  }
+  pthread_mutex_unlock(&pool_lock);
+  if (!buffer) {
+    LOG_ERROR("Failed to allocate %zu byte packet buffer", capacity);
+    return NULL;
+  }
+  buffer->size_class = size_class < PACKET_POOL_CLASS_COUNT ? size_class : -1;
+  buffer->capacity = capacity;
+  return buffer->data;
+}
+
+size_t packet_pool_capacity(const uint8_t *buffer) {
+  return header_of(buffer)->capacity;
+}
+
+void packet_pool_release(uint8_t *data) {
+  if (!data) {
+    return;
+  }
+  PooledBuffer *buffer = header_of(data);
+  pthread_mutex_lock(&pool_lock);
+  pool_stats.outstanding--;
+  if (buffer->size_class >= 0) {
+    buffer->next = free_lists[buffer->size_class];
+    free_lists[buffer->size_class] = buffer;
+    buffer = NULL;
+  }
+  pthread_mutex_unlock(&pool_lock);
+  free(buffer);
+}
+
+// ENet calls this once the last peer has finished with the packet
+static void release_packet_data(ENetPacket *packet) {
+  packet_pool_release(packet->data);
+}
+
+// Turn a filled buffer into a packet without copying it. The packet owns the
+// buffer from here on, also when NULL is returned.
+ENetPacket *packet_pool_wrap(uint8_t *buffer, size_t length, enet_uint32 flags) {
+  if (!buffer) {
+    return NULL;
+  }
+  ENetPacket *packet = enet_packet_create(buffer, length, flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+  if (!packet) {
+    packet_pool_release(buffer);
+    return NULL;
+  }
+  packet->freeCallback = release_packet_data;
+  return packet;
+}
+
+// Pooled stand-in for enet_packet_create() for small fixed-size packets
+ENetPacket *packet_pool_create(const void *data, size_t length, enet_uint32 flags) {
+  uint8_t *buffer = packet_pool_acquire(length);
+  if (!buffer) {
+    return NULL;
+  }
+  memcpy(buffer, data, length);
+  return packet_pool_wrap(buffer, length, flags);
+}
+
+void packet_pool_stats(PacketPoolStats *stats) {
+  pthread_mutex_lock(&pool_lock);
+  *stats = pool_stats;
+  pthread_mutex_unlock(&pool_lock);
+}
+
+// Free every pooled buffer. Buffers still inside packets are freed when the
+// packets are destroyed.
+void packet_pool_shutdown(void) {
+  pthread_mutex_lock(&pool_lock);
+  for (int i = 0; i < PACKET_POOL_CLASS_COUNT; i++) {
+    while (free_lists[i]) {
+      PooledBuffer *buffer = free_lists[i];
+      free_lists[i] = buffer->next;
+      free(buffer);
+    }
+  }
+  pthread_mutex_unlock(&pool_lock);
+}
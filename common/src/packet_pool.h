@@ -0,0 +1,34 @@
+#ifndef PACKET_POOL_H
+#define PACKET_POOL_H
+
+#include <enet/enet.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Buffer sizes handed out by the pool; larger requests get a one-off buffer
+#define PACKET_POOL_CLASS_COUNT 3
+#define PACKET_POOL_SMALL 64     // Fixed-size control packets
+#define PACKET_POOL_MEDIUM 512   // Tile chunks, input, stats
+#define PACKET_POOL_LARGE 8192   // Snapshots
+
+// Counters for the shutdown report
+typedef struct {
+  uint64_t allocated;   // Buffers ever allocated
+  uint64_t acquired;    // Buffers handed out, reused or not
+  uint64_t outstanding; // Buffers currently handed out
+} PacketPoolStats;
+
+// Packet payloads live in recycled buffers of a few size classes. Packets
+// are created with ENET_PACKET_FLAG_NO_ALLOCATE so ENet sends straight from
+// the buffer, and ENet's free callback puts the buffer back once the last
+// peer is done with the packet. Buffers may be released on any thread.
+uint8_t *packet_pool_acquire(size_t size);
+size_t packet_pool_capacity(const uint8_t *buffer);
+void packet_pool_release(uint8_t *buffer);
+ENetPacket *packet_pool_wrap(uint8_t *buffer, size_t length, enet_uint32 flags);
+ENetPacket *packet_pool_create(const void *data, size_t length, enet_uint32 flags);
+void packet_pool_stats(PacketPoolStats *stats);
+void packet_pool_shutdown(void);
+
+#endif // PACKET_POOL_H
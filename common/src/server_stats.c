@@ -0,0 +1,28 @@
+#include "server_stats.h"
+
+void server_stats_write_packet(WireWriter *w, const ServerStats *stats) {
+  wire_write_u8(w, PKT_SERVER_STATS);
+  wire_write_u32(w, stats->tick);
+  wire_write_u16(w, stats->tick_rate);
+  wire_write_u16(w, stats->players);
+  wire_write_u32(w, stats->overruns);
+  wire_write_u32(w, stats->tick_samples);
+  wire_write_u32(w, stats->tick_p50_us);
+  wire_write_u32(w, stats->tick_p90_us);
+  wire_write_u32(w, stats->tick_p99_us);
+  wire_write_u32(w, stats->tick_max_us);
+}
+
+bool server_stats_read_packet(WireReader *r, ServerStats *stats) {
+  wire_read_u8(r); // Packet type
+  stats->tick = wire_read_u32(r);
+  stats->tick_rate = wire_read_u16(r);
+  stats->players = wire_read_u16(r);
+  stats->overruns = wire_read_u32(r);
+  stats->tick_samples = wire_read_u32(r);
+  stats->tick_p50_us = wire_read_u32(r);
+  stats->tick_p90_us = wire_read_u32(r);
+  stats->tick_p99_us = wire_read_u32(r);
+  stats->tick_max_us = wire_read_u32(r);
+  return !r->overflow;
+}
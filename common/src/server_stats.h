@@ -0,0 +1,27 @@
+#ifndef SERVER_STATS_H
+#define SERVER_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+#include "wire.h"
+
+#define SERVER_STATS_PACKET_SIZE (1 + 4 + 2 + 2 + 4 + 4 + 4 * 4)
+
+// Server health, sent in reply to PKT_STATS_REQUEST for load testing
+typedef struct {
+  uint32_t tick;
+  uint16_t tick_rate;
+  uint16_t players;
+  uint32_t overruns;
+  uint32_t tick_samples; // Ticks the percentiles below were taken from
+  uint32_t tick_p50_us;
+  uint32_t tick_p90_us;
+  uint32_t tick_p99_us;
+  uint32_t tick_max_us;
+} ServerStats;
+
+void server_stats_write_packet(WireWriter *w, const ServerStats *stats);
+bool server_stats_read_packet(WireReader *r, ServerStats *stats);
+
+#endif // SERVER_STATS_H
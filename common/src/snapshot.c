@@ -0,0 +1,226 @@
+#include "snapshot.h"
+#include <stdlib.h>
+#include <string.h>
+
+void snapshot_history_reset(SnapshotHistory *history) {
+  for (int i = 0; i < SNAPSHOT_HISTORY; i++) {
+    history->frames[i].sequence = 0;
+    history->frames[i].entity_count = 0;
+  }
+  history->last_sequence = 0;
+  history->acked_sequence = 0;
+}
+
+void snapshot_history_store(SnapshotHistory *history, const Snapshot *snapshot) {
+  Snapshot *slot = &history->frames[snapshot->sequence % SNAPSHOT_HISTORY];
+  slot->sequence = snapshot->sequence;
+  slot->entity_count = snapshot->entity_count;
+  memcpy(slot->entities, snapshot->entities,
+         sizeof(SnapshotEntity) * snapshot->entity_count);
+  history->last_sequence = snapshot->sequence;
+}
+
+// Look up a stored snapshot, NULL if it was never stored or has been overwritten
+const Snapshot *snapshot_history_find(const SnapshotHistory *history, uint32_t sequence) {
+  if (sequence == 0) {
+    return NULL;
+  }
+  const Snapshot *slot = &history->frames[sequence % SNAPSHOT_HISTORY];
+  return slot->sequence == sequence ? slot : NULL;
+}
+
+void snapshot_clear(Snapshot *snapshot, uint32_t sequence) {
+  snapshot->sequence = sequence;
+  snapshot->entity_count = 0;
+}
+
+bool snapshot_add_entity(Snapshot *snapshot, uint16_t id, int32_t x, int32_t y) {
+  if (snapshot->entity_count >= SNAPSHOT_MAX_ENTITIES) {
+    return false;
+  }
+  SnapshotEntity *entity = &snapshot->entities[snapshot->entity_count++];
+  entity->id = id;
+  entity->x = x;
+  entity->y = y;
+  return true;
+}
+
+static int compare_entity_id(const void *a, const void *b) {
+  return (int)((const SnapshotEntity *)a)->id - (int)((const SnapshotEntity *)b)->id;
+}
+
+// Entities must be sorted by id before a snapshot is delta encoded
+void snapshot_sort(Snapshot *snapshot) {
+  qsort(snapshot->entities, snapshot->entity_count, sizeof(SnapshotEntity),
+        compare_entity_id);
+}
+
+const SnapshotEntity *snapshot_find_entity(const Snapshot *snapshot, uint16_t id) {
+  int lo = 0;
+  int hi = snapshot->entity_count - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (snapshot->entities[mid].id == id) {
+      return &snapshot->entities[mid];
+    }
+    if (snapshot->entities[mid].id < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return NULL;
+}
+
+// Write one delta entry; returns false when nothing changed
+static bool write_entry(WireWriter *w, uint16_t *last_id, const SnapshotEntity *base,
+                        const SnapshotEntity *entity) {
+  const SnapshotEntity zero = {0};
+  unsigned char flags = 0;
+
+  if (!entity) {
+    flags = SNAP_REMOVED;
+    entity = base;
+  } else {
+    if (!base) {
+      base = &zero;
+    }
+    if (entity->x != base->x) flags |= SNAP_FIELD_X;
+    if (entity->y != base->y) flags |= SNAP_FIELD_Y;
+    // A new entity is always written, even if its fields match the zero base
+    if (flags == 0 && base != &zero) {
+      return false;
+    }
+  }
+
+  if (w) {
+    wire_write_varint(w, entity->id - *last_id);
+    wire_write_u8(w, flags);
+    if (flags & SNAP_FIELD_X) wire_write_svarint(w, entity->x - base->x);
+    if (flags & SNAP_FIELD_Y) wire_write_svarint(w, entity->y - base->y);
+  }
+  *last_id = entity->id;
+  return true;
+}
+
+// Walk both sorted entity lists and emit the changes; with w == NULL only counts
+static int walk_delta(WireWriter *w, const Snapshot *from, const Snapshot *to) {
+  int from_count = from ? from->entity_count : 0;
+  int i = 0;
+  int j = 0;
+  int changes = 0;
+  uint16_t last_id = 0;
+
+  while (i < from_count || j < to->entity_count) {
+    const SnapshotEntity *base = i < from_count ? &from->entities[i] : NULL;
+    const SnapshotEntity *entity = j < to->entity_count ? &to->entities[j] : NULL;
+
+    if (base && (!entity || base->id < entity->id)) {
+      changes += write_entry(w, &last_id, base, NULL);
+      i++;
+    } else if (entity && (!base || entity->id < base->id)) {
+      changes += write_entry(w, &last_id, NULL, entity);
+      j++;
+    } else {
+      changes += write_entry(w, &last_id, base, entity);
+      i++;
+      j++;
+    }
+  }
+  return changes;
+}
+
+// Encode the changes from one snapshot to the next; from may be NULL for a full update.
+// Returns the number of entity entries written.
+int snapshot_write_delta(WireWriter *w, const Snapshot *from, const Snapshot *to) {
+  int changes = walk_delta(NULL, from, to);
+  wire_write_varint(w, changes);
+  walk_delta(w, from, to);
+  return changes;
+}
+
+// Rebuild a snapshot from its baseline and an encoded delta
+bool snapshot_read_delta(WireReader *r, const Snapshot *from, Snapshot *to) {
+  int from_count = from ? from->entity_count : 0;
+  int i = 0;
+  uint32_t id = 0;
+  uint32_t changes = wire_read_varint(r);
+
+  to->entity_count = 0;
+  for (uint32_t n = 0; n < changes && !r->overflow; n++) {
+    uint32_t id_delta = wire_read_varint(r);
+    if (n > 0 && id_delta == 0) {
+      return false; // Ids must be strictly increasing
+    }
+    id += id_delta;
+    unsigned char flags = wire_read_u8(r);
+    if (id > UINT16_MAX) {
+      return false;
+    }
+
+    // Carry over unchanged entities that sort before this one
+    while (i < from_count && from->entities[i].id < id) {
+      if (to->entity_count >= SNAPSHOT_MAX_ENTITIES) return false;
+      to->entities[to->entity_count++] = from->entities[i++];
+    }
+
+    SnapshotEntity entity = {(uint16_t)id, 0, 0};
+    if (i < from_count && from->entities[i].id == id) {
+      entity = from->entities[i++];
+    }
+    if (flags & SNAP_REMOVED) {
+      continue;
+    }
+    if (flags & SNAP_FIELD_X) entity.x += wire_read_svarint(r);
+    if (flags & SNAP_FIELD_Y) entity.y += wire_read_svarint(r);
+
+    if (to->entity_count >= SNAPSHOT_MAX_ENTITIES) return false;
+    to->entities[to->entity_count++] = entity;
+  }
+
+  while (i < from_count) {
+    if (to->entity_count >= SNAPSHOT_MAX_ENTITIES) return false;
+    to->entities[to->entity_count++] = from->entities[i++];
+  }
+  return !r->overflow;
+}
+
+// Write a complete PKT_SNAPSHOT packet; returns the number of changed entities
+int snapshot_write_packet(WireWriter *w, const Snapshot *baseline, const Snapshot *snapshot,
+                          uint32_t input_ack) {
+  wire_write_u8(w, PKT_SNAPSHOT);
+  wire_write_u32(w, snapshot->sequence);
+  wire_write_u32(w, baseline ? baseline->sequence : 0);
+  wire_write_u32(w, input_ack);
+  return snapshot_write_delta(w, baseline, snapshot);
+}
+
+// Read a PKT_SNAPSHOT packet against the snapshots received so far.
+// The header fields are filled in even when the delta cannot be applied.
+SnapshotReadResult snapshot_read_packet(WireReader *r, const SnapshotHistory *history,
+                                        Snapshot *snapshot, uint32_t *baseline_sequence,
+                                        uint32_t *input_ack) {
+  wire_read_u8(r); // Packet type
+  snapshot->sequence = wire_read_u32(r);
+  *baseline_sequence = wire_read_u32(r);
+  *input_ack = wire_read_u32(r);
+  if (r->overflow) {
+    return SNAPSHOT_READ_MALFORMED;
+  }
+  // Anything older than the newest snapshot is superseded
+  if (snapshot->sequence <= history->last_sequence) {
+    return SNAPSHOT_READ_STALE;
+  }
+
+  const Snapshot *baseline = NULL;
+  if (*baseline_sequence != 0) {
+    baseline = snapshot_history_find(history, *baseline_sequence);
+    if (!baseline) {
+      return SNAPSHOT_READ_NO_BASELINE;
+    }
+  }
+  if (!snapshot_read_delta(r, baseline, snapshot)) {
+    return SNAPSHOT_READ_MALFORMED;
+  }
+  return SNAPSHOT_READ_OK;
+}
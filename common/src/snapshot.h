@@ -0,0 +1,79 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "common.h"
+#include "wire.h"
+
+// Number of past snapshots kept on each side to serve as delta baselines
+#define SNAPSHOT_HISTORY 32
+// Most players one client is sent; a crowd larger than this inside the area
+// of interest is cut down to the players nearest the viewer rather than
+// growing every client's history
+#define SNAPSHOT_MAX_ENTITIES 128
+
+// Per-entity flags in a delta entry
+#define SNAP_FIELD_X 0x01
+#define SNAP_FIELD_Y 0x02
+#define SNAP_REMOVED 0x80
+
+// Snapshot header: type, sequence, baseline sequence (0 = none), newest input
+// sequence the server has processed for this client, change count
+#define SNAPSHOT_HEADER_SIZE (1 + 4 + 4 + 4 + VARINT_MAX_SIZE)
+// Worst case per entity: id delta, flags, two coordinate deltas
+#define SNAPSHOT_ENTRY_MAX_SIZE (VARINT_MAX_SIZE + 1 + 2 * VARINT_MAX_SIZE)
+#define SNAPSHOT_MAX_PACKET_SIZE \
+  (SNAPSHOT_HEADER_SIZE + 2 * SNAPSHOT_MAX_ENTITIES * SNAPSHOT_ENTRY_MAX_SIZE)
+
+typedef struct {
+  uint16_t id;
+  int32_t x;
+  int32_t y;
+} SnapshotEntity;
+
+// World state as seen by one client, entities sorted by id
+typedef struct {
+  uint32_t sequence; // 0 marks an unused slot
+  int entity_count;
+  SnapshotEntity entities[SNAPSHOT_MAX_ENTITIES];
+} Snapshot;
+
+// Ring of recent snapshots indexed by sequence
+typedef struct {
+  Snapshot frames[SNAPSHOT_HISTORY];
+  uint32_t last_sequence;  // Newest stored snapshot
+  uint32_t acked_sequence; // Newest snapshot the remote side confirmed
+} SnapshotHistory;
+
+typedef struct {
+  unsigned char type;
+  uint32_t sequence;
+} SnapshotAckPacket;
+
+// Outcome of reading a PKT_SNAPSHOT packet
+typedef enum {
+  SNAPSHOT_READ_OK,
+  SNAPSHOT_READ_STALE,       // Not newer than the last snapshot received
+  SNAPSHOT_READ_NO_BASELINE, // Delta against a snapshot no longer kept
+  SNAPSHOT_READ_MALFORMED,
+} SnapshotReadResult;
+
+void snapshot_history_reset(SnapshotHistory *history);
+void snapshot_history_store(SnapshotHistory *history, const Snapshot *snapshot);
+const Snapshot *snapshot_history_find(const SnapshotHistory *history, uint32_t sequence);
+
+void snapshot_clear(Snapshot *snapshot, uint32_t sequence);
+bool snapshot_add_entity(Snapshot *snapshot, uint16_t id, int32_t x, int32_t y);
+void snapshot_sort(Snapshot *snapshot);
+const SnapshotEntity *snapshot_find_entity(const Snapshot *snapshot, uint16_t id);
+
+int snapshot_write_delta(WireWriter *w, const Snapshot *from, const Snapshot *to);
+bool snapshot_read_delta(WireReader *r, const Snapshot *from, Snapshot *to);
+int snapshot_write_packet(WireWriter *w, const Snapshot *baseline, const Snapshot *snapshot,
+                          uint32_t input_ack);
+SnapshotReadResult snapshot_read_packet(WireReader *r, const SnapshotHistory *history,
+                                        Snapshot *snapshot, uint32_t *baseline_sequence,
+                                        uint32_t *input_ack);
+
+#endif // SNAPSHOT_H
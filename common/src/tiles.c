@@ -0,0 +1,17 @@
+#include "tiles.h"
+
+const unsigned char tile_properties[256] = {
+  [TILE_GRASS] = TILE_FLAG_WALKABLE,
+};
+
+bool tile_is_walkable(unsigned char tile_id) {
+  return (tile_properties[tile_id] & TILE_FLAG_WALKABLE) != 0;
+}
+
+// Build an in-memory tile with its properties filled in from the table
+Tile tile_from_id(unsigned char tile_id) {
+  Tile tile;
+  tile.tile_id = tile_id;
+  tile.walkable = tile_is_walkable(tile_id);
+  return tile;
+}
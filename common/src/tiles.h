@@ -0,0 +1,24 @@
+#ifndef TILES_H
+#define TILES_H
+
+#include <stdbool.h>
+#include "common.h"
+
+// Tile ids used by the maps
+#define TILE_VOID 0
+#define TILE_GRASS 1
+#define TILE_WATER 2
+#define TILE_SAND 3
+#define TILE_STONE 4
+
+// Tile property flags
+#define TILE_FLAG_WALKABLE 0x01
+
+// Properties of every tile id, shared by client and server so they never
+// have to be sent over the wire
+extern const unsigned char tile_properties[256];
+
+bool tile_is_walkable(unsigned char tile_id);
+Tile tile_from_id(unsigned char tile_id);
+
+#endif // TILES_H
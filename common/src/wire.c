@@ -0,0 +1,110 @@
+#include "wire.h"
+#include <string.h>
+
+void wire_writer_init(WireWriter *w, void *buffer, size_t capacity) {
+  w->data = (uint8_t *)buffer;
+  w->capacity = capacity;
+  w->size = 0;
+  w->overflow = false;
+}
+
+void wire_write_u8(WireWriter *w, uint8_t value) {
+  if (w->size + 1 > w->capacity) {
+    w->overflow = true;
+    return;
+  }
+  w->data[w->size++] = value;
+}
+
+void wire_write_u16(WireWriter *w, uint16_t value) {
+  wire_write_u8(w, (uint8_t)value);
+  wire_write_u8(w, (uint8_t)(value >> 8));
+}
+
+void wire_write_u32(WireWriter *w, uint32_t value) {
+  wire_write_u16(w, (uint16_t)value);
+  wire_write_u16(w, (uint16_t)(value >> 16));
+}
+
+// Unsigned LEB128: 7 bits per byte, high bit set while more bytes follow
+void wire_write_varint(WireWriter *w, uint32_t value) {
+  while (value >= 0x80) {
+    wire_write_u8(w, (uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  wire_write_u8(w, (uint8_t)value);
+}
+
+// Zigzag-encode so small negative numbers stay small
+void wire_write_svarint(WireWriter *w, int32_t value) {
+  wire_write_varint(w, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+void wire_write_bytes(WireWriter *w, const void *bytes, size_t count) {
+  if (w->size + count > w->capacity) {
+    w->overflow = true;
+    return;
+  }
+  memcpy(w->data + w->size, bytes, count);
+  w->size += count;
+}
+
+void wire_reader_init(WireReader *r, const void *buffer, size_t size) {
+  r->data = (const uint8_t *)buffer;
+  r->size = size;
+  r->offset = 0;
+  r->overflow = false;
+}
+
+uint8_t wire_read_u8(WireReader *r) {
+  if (r->offset + 1 > r->size) {
+    r->overflow = true;
+    return 0;
+  }
+  return r->data[r->offset++];
+}
+
+uint16_t wire_read_u16(WireReader *r) {
+  uint16_t lo = wire_read_u8(r);
+  uint16_t hi = wire_read_u8(r);
+  return (uint16_t)(lo | (hi << 8));
+}
+
+uint32_t wire_read_u32(WireReader *r) {
+  uint32_t lo = wire_read_u16(r);
+  uint32_t hi = wire_read_u16(r);
+  return lo | (hi << 16);
+}
+
+uint32_t wire_read_varint(WireReader *r) {
+  uint32_t value = 0;
+  for (int shift = 0; shift < 7 * VARINT_MAX_SIZE; shift += 7) {
+    uint8_t byte = wire_read_u8(r);
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return value;
+    }
+  }
+  // Too many continuation bytes: treat the packet as malformed
+  r->overflow = true;
+  return 0;
+}
+
+int32_t wire_read_svarint(WireReader *r) {
+  uint32_t value = wire_read_varint(r);
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+void wire_read_bytes(WireReader *r, void *bytes, size_t count) {
+  if (r->offset + count > r->size) {
+    r->overflow = true;
+    memset(bytes, 0, count);
+    return;
+  }
+  memcpy(bytes, r->data + r->offset, count);
+  r->offset += count;
+}
+
+size_t wire_remaining(const WireReader *r) {
+  return r->size - r->offset;
+}
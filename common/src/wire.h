@@ -0,0 +1,45 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Largest encoded size of a 32-bit varint
+#define VARINT_MAX_SIZE 5
+
+// Little-endian writer over a caller-owned buffer.
+// Writes past the end set overflow instead of touching memory.
+typedef struct {
+  uint8_t *data;
+  size_t capacity;
+  size_t size;
+  bool overflow;
+} WireWriter;
+
+// Reader counterpart; reads past the end return 0 and set overflow
+typedef struct {
+  const uint8_t *data;
+  size_t size;
+  size_t offset;
+  bool overflow;
+} WireReader;
+
+void wire_writer_init(WireWriter *w, void *buffer, size_t capacity);
+void wire_write_u8(WireWriter *w, uint8_t value);
+void wire_write_u16(WireWriter *w, uint16_t value);
+void wire_write_u32(WireWriter *w, uint32_t value);
+void wire_write_varint(WireWriter *w, uint32_t value);
+void wire_write_svarint(WireWriter *w, int32_t value);
+void wire_write_bytes(WireWriter *w, const void *bytes, size_t count);
+
+void wire_reader_init(WireReader *r, const void *buffer, size_t size);
+uint8_t wire_read_u8(WireReader *r);
+uint16_t wire_read_u16(WireReader *r);
+uint32_t wire_read_u32(WireReader *r);
+uint32_t wire_read_varint(WireReader *r);
+int32_t wire_read_svarint(WireReader *r);
+void wire_read_bytes(WireReader *r, void *bytes, size_t count);
+size_t wire_remaining(const WireReader *r);
+
+#endif // WIRE_H
@@ -2,6 +2,8 @@
 #ifndef CRIOGENIO_H
 #define CRIOGENIO_H
 
+#include "entities.h"
+
 //The main entrypoint for the game
 typedef struct {
 
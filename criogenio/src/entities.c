@@ -0,0 +1,206 @@
+#include "entities.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HANDLE_SLOT(handle) ((int)((handle) & 0xFFFF))
+#define HANDLE_GENERATION(handle) ((uint16_t)(((handle) >> 16) & 0xFFF))
+
+static EntityHandle make_handle(int type, uint16_t generation, int slot) {
+  return (EntityHandle)type << 28 | (EntityHandle)(generation & 0xFFF) << 16 | (EntityHandle)slot;
+}
+
+// Resize every array of a pool; the pointers are only replaced once all
+// allocations succeeded
+static bool pool_reserve(EntityPool *pool, int capacity) {
+  if (capacity <= pool->capacity) {
+    return true;
+  }
+  if (capacity > ENTITY_MAX_PER_TYPE) {
+    capacity = ENTITY_MAX_PER_TYPE;
+    if (capacity <= pool->capacity) {
+      return false;
+    }
+  }
+#define GROW(field)                                                              \
+  do {                                                                           \
+    void *grown = realloc(pool->field, (size_t)capacity * sizeof(*pool->field)); \
+    if (!grown) {                                                                \
+      return false;                                                              \
+    }                                                                            \
+    pool->field = grown;                                                         \
+  } while (0)
+  GROW(x);
+  GROW(y);
+  GROW(vx);
+  GROW(vy);
+  GROW(timer);
+  GROW(health);
+  GROW(owner);
+  GROW(slot);
+  GROW(dense);
+  GROW(generations);
+  GROW(free_slots);
+#undef GROW
+  pool->capacity = capacity;
+  return true;
+}
+
+static void pool_free(EntityPool *pool) {
+  free(pool->x);
+  free(pool->y);
+  free(pool->vx);
+  free(pool->vy);
+  free(pool->timer);
+  free(pool->health);
+  free(pool->owner);
+  free(pool->slot);
+  free(pool->dense);
+  free(pool->generations);
+  free(pool->free_slots);
+  int type = pool->type;
+  memset(pool, 0, sizeof(*pool));
+  pool->type = type;
+}
+
+// Set up one empty pool per type; initial_capacity entities of each type
+// fit before the first allocation
+bool entity_world_init(EntityWorld *world, int type_count, int initial_capacity) {
+  if (type_count < 1 || type_count > ENTITY_MAX_TYPES) {
+    return false;
+  }
+  memset(world, 0, sizeof(*world));
+  world->type_count = type_count;
+  for (int type = 0; type < type_count; type++) {
+    world->pools[type].type = type;
+    if (initial_capacity > 0 && !pool_reserve(&world->pools[type], initial_capacity)) {
+      entity_world_destroy(world);
+      return false;
+    }
+  }
+  return true;
+}
+
+void entity_world_destroy(EntityWorld *world) {
+  for (int type = 0; type < ENTITY_MAX_TYPES; type++) {
+    pool_free(&world->pools[type]);
+  }
+  world->type_count = 0;
+}
+
+// Destroy every entity but keep the memory; old handles stay invalid
+void entity_world_clear(EntityWorld *world) {
+  for (int type = 0; type < world->type_count; type++) {
+    EntityPool *pool = &world->pools[type];
+    while (pool->count > 0) {
+      entity_destroy_at(pool, pool->count - 1);
+    }
+  }
+}
+
+EntityPool *entity_pool(EntityWorld *world, int type) {
+  if (type < 0 || type >= world->type_count) {
+    return NULL;
+  }
+  return &world->pools[type];
+}
+
+// Add an entity with zeroed components, ENTITY_HANDLE_NONE if the pool is full
+EntityHandle entity_spawn(EntityWorld *world, int type) {
+  EntityPool *pool = entity_pool(world, type);
+  if (!pool) {
+    return ENTITY_HANDLE_NONE;
+  }
+  if (pool->count == pool->capacity &&
+      !pool_reserve(pool, pool->capacity > 0 ? pool->capacity * 2 : 64)) {
+    return ENTITY_HANDLE_NONE;
+  }
+
+  int slot;
+  if (pool->free_count > 0) {
+    slot = pool->free_slots[--pool->free_count];
+  } else {
+    slot = pool->slot_count++;
+    // Generations start at 1 so ENTITY_HANDLE_NONE never resolves
+    pool->generations[slot] = 1;
+  }
+
+  int index = pool->count++;
+  pool->dense[slot] = index;
+  pool->slot[index] = (uint16_t)slot;
+  pool->x[index] = 0;
+  pool->y[index] = 0;
+  pool->vx[index] = 0;
+  pool->vy[index] = 0;
+  pool->timer[index] = 0;
+  pool->health[index] = 0;
+  pool->owner[index] = 0;
+  return make_handle(type, pool->generations[slot], slot);
+}
+
+// Dense index of a live entity, -1 once it has been destroyed
+int entity_index(const EntityWorld *world, EntityHandle handle) {
+  int type = entity_handle_type(handle);
+  if (type >= world->type_count) {
+    return -1;
+  }
+  const EntityPool *pool = &world->pools[type];
+  int slot = HANDLE_SLOT(handle);
+  if (slot >= pool->slot_count || pool->dense[slot] < 0 ||
+      (pool->generations[slot] & 0xFFF) != HANDLE_GENERATION(handle)) {
+    return -1;
+  }
+  return pool->dense[slot];
+}
+
+EntityHandle entity_handle_at(const EntityPool *pool, int index) {
+  int slot = pool->slot[index];
+  return make_handle(pool->type, pool->generations[slot], slot);
+}
+
+// Remove the entity at a dense index by moving the last one into its place.
+// Loops that destroy while iterating should run from the back.
+void entity_destroy_at(EntityPool *pool, int index) {
+  int slot = pool->slot[index];
+  int last = --pool->count;
+  if (index != last) {
+    pool->x[index] = pool->x[last];
+    pool->y[index] = pool->y[last];
+    pool->vx[index] = pool->vx[last];
+    pool->vy[index] = pool->vy[last];
+    pool->timer[index] = pool->timer[last];
+    pool->health[index] = pool->health[last];
+    pool->owner[index] = pool->owner[last];
+    pool->slot[index] = pool->slot[last];
+    pool->dense[pool->slot[index]] = index;
+  }
+  pool->dense[slot] = -1;
+  pool->generations[slot] = (pool->generations[slot] + 1) & 0xFFF;
+  if (pool->generations[slot] == 0) {
+    pool->generations[slot] = 1;
+  }
+  pool->free_slots[pool->free_count++] = (uint16_t)slot;
+}
+
+bool entity_destroy(EntityWorld *world, EntityHandle handle) {
+  int index = entity_index(world, handle);
+  if (index < 0) {
+    return false;
+  }
+  entity_destroy_at(&world->pools[entity_handle_type(handle)], index);
+  return true;
+}
+
+// Move every entity by its velocity and run down its timer
+void entity_pool_integrate(EntityPool *pool, float dt) {
+  int count = pool->count;
+  float *restrict x = pool->x;
+  float *restrict y = pool->y;
+  const float *restrict vx = pool->vx;
+  const float *restrict vy = pool->vy;
+  float *restrict timer = pool->timer;
+  for (int i = 0; i < count; i++) {
+    x[i] += vx[i] * dt;
+    y[i] += vy[i] * dt;
+    timer[i] -= dt;
+  }
+}
@@ -0,0 +1,65 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Entity types a world can hold; each type gets its own pool
+#define ENTITY_MAX_TYPES 16
+// Slots per type; slot indices go into 16 bits of a handle
+#define ENTITY_MAX_PER_TYPE 0xFFFF
+
+// Reference to an entity that goes stale once it is destroyed:
+// slot in the low 16 bits, slot generation in the next 12, type in the top 4
+typedef uint32_t EntityHandle;
+#define ENTITY_HANDLE_NONE 0
+
+// Entities of one type, components stored as parallel arrays.
+// Live entities are packed into indices [0, count) so batch updates walk
+// contiguous memory; slots give every entity a stable handle on top.
+typedef struct {
+  int type;
+  int count;    // Live entities
+  int capacity; // Room in every array below, grows on demand
+
+  // Components, indexed by dense index
+  float *x;
+  float *y;
+  float *vx;
+  float *vy;
+  float *timer;    // Seconds left; meaning is up to the entity type
+  int32_t *health;
+  uint32_t *owner; // Player id or handle of whatever spawned the entity
+  uint16_t *slot;  // Slot owning each dense index
+
+  // Slot table, indexed by the slot in a handle
+  int32_t *dense;        // Dense index of each slot, -1 if free
+  uint16_t *generations; // Bumped each time a slot is freed
+  uint16_t *free_slots;  // Stack of unused slots
+  int free_count;
+  int slot_count;        // Slots handed out so far
+} EntityPool;
+
+typedef struct {
+  EntityPool pools[ENTITY_MAX_TYPES];
+  int type_count;
+} EntityWorld;
+
+bool entity_world_init(EntityWorld *world, int type_count, int initial_capacity);
+void entity_world_destroy(EntityWorld *world);
+void entity_world_clear(EntityWorld *world);
+EntityPool *entity_pool(EntityWorld *world, int type);
+
+EntityHandle entity_spawn(EntityWorld *world, int type);
+bool entity_destroy(EntityWorld *world, EntityHandle handle);
+int entity_index(const EntityWorld *world, EntityHandle handle);
+EntityHandle entity_handle_at(const EntityPool *pool, int index);
+void entity_destroy_at(EntityPool *pool, int index);
+
+static inline int entity_handle_type(EntityHandle handle) {
+  return (int)(handle >> 28);
+}
+
+void entity_pool_integrate(EntityPool *pool, float dt);
+
+#endif // ENTITIES_H
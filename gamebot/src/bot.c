@@ -0,0 +1,462 @@
+#include <enet/enet.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../common/src/common.h"
+#include "../../common/src/input.h"
+#include "../../common/src/log.h"
+#include "../../common/src/server_stats.h"
+#include "../../common/src/snapshot.h"
+#include "../../common/src/wire.h"
+
+// Headless load-test client: opens many connections from one ENet host, drives
+// each player with scripted input and reports what the server sends back.
+
+#define DEFAULT_BOT_COUNT 64
+#define DEFAULT_CONNECT_RATE 50 // New connections per second
+#define REPORT_INTERVAL_MS 1000
+// Steps walked along each side in square mode
+#define SQUARE_SIDE 10
+
+typedef enum {
+  BOT_IDLE,       // Not connected yet
+  BOT_CONNECTING, // Waiting for the connection or the player id
+  BOT_JOINED,     // Has a player and is sending input
+  BOT_REJECTED,   // Disconnected before getting a player
+  BOT_DROPPED,    // Disconnected after joining
+} BotState;
+
+typedef enum {
+  MOVE_RANDOM,
+  MOVE_SQUARE,
+} MoveMode;
+
+typedef struct {
+  ENetPeer *peer;
+  BotState state;
+  int player_id;
+  enet_uint32 connect_ms; // When the connection was started
+  enet_uint32 join_ms;    // Time from connecting to receiving the player id
+  SnapshotHistory *snapshots;
+  InputWindow inputs;
+  // Movement script
+  int dir_x;
+  int dir_y;
+  int steps_left;
+  int side;
+  // Counters for the current report window
+  int snapshots_received;
+  size_t bytes_in;
+  size_t bytes_out;
+} Bot;
+
+typedef struct {
+  const char *host;
+  int port;
+  int bot_count;
+  int duration;     // Seconds, 0 runs until interrupted
+  int connect_rate;
+  MoveMode mode;
+} BotConfig;
+
+// Totals over the whole run
+typedef struct {
+  int snapshots;
+  size_t bytes_in;
+  size_t bytes_out;
+  int malformed;
+  int missing_baselines;
+} BotTotals;
+
+static BotConfig config = {"localhost", 8081, DEFAULT_BOT_COUNT, 30, DEFAULT_CONNECT_RATE, MOVE_RANDOM};
+static Bot *bots;
+static ENetHost *host;
+static ServerStats server_stats;
+static bool have_server_stats = false;
+static BotTotals totals;
+static volatile sig_atomic_t running = 1;
+// Commands each bot sends per second: the server's tick rate once known
+static int input_rate = INPUT_RATE;
+
+static void signal_handler(int signum) {
+  (void)signum;
+  running = 0;
+}
+
+static void print_usage(const char *program) {
+  printf("Usage: %s [--host <address>] [--port <port>] [--bots <count>] [--duration <seconds>]"
+         " [--mode <random|square>] [--connect-rate <per second>]"
+         " [--log-level <trace|debug|info|warn|error|off>]\n",
+         program);
+}
+
+static bool parse_args(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+      config.host = argv[++i];
+    } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+      config.port = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--bots") == 0 && i + 1 < argc) {
+      config.bot_count = atoi(argv[++i]);
+      if (config.bot_count <= 0 || config.bot_count > ENET_PROTOCOL_MAXIMUM_PEER_ID) {
+        printf("Bot count must be between 1 and %d\n", ENET_PROTOCOL_MAXIMUM_PEER_ID);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc) {
+      config.duration = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--connect-rate") == 0 && i + 1 < argc) {
+      config.connect_rate = atoi(argv[++i]);
+      if (config.connect_rate <= 0) {
+        printf("Connect rate must be positive\n");
+        return false;
+      }
+    } else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+      const char *mode = argv[++i];
+      if (strcmp(mode, "random") == 0) {
+        config.mode = MOVE_RANDOM;
+      } else if (strcmp(mode, "square") == 0) {
+        config.mode = MOVE_SQUARE;
+      } else {
+        printf("Unknown movement mode: %s\n", mode);
+        return false;
+      }
+    } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+      int level = log_parse_level(argv[++i]);
+      if (level < 0) {
+        printf("Unknown log level: %s\n", argv[i]);
+        return false;
+      }
+      log_set_level(level);
+    } else {
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static void bot_send(Bot *bot, const void *data, size_t length, enet_uint32 flags) {
+  ENetPacket *packet = enet_packet_create(data, length, flags);
+  if (enet_peer_send(bot->peer, CHANNEL_STATE, packet) == 0) {
+    bot->bytes_out += length;
+  } else {
+    enet_packet_destroy(packet);
+  }
+}
+
+// Pick the next direction from the bot's movement script
+static void bot_next_move(Bot *bot) {
+  if (bot->steps_left > 0) {
+    bot->steps_left--;
+    return;
+  }
+  if (config.mode == MOVE_SQUARE) {
+    static const int sides[4][2] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+    bot->side = (bot->side + 1) % 4;
+    bot->dir_x = sides[bot->side][0];
+    bot->dir_y = sides[bot->side][1];
+    bot->steps_left = SQUARE_SIDE - 1;
+  } else {
+    // Hold a random direction, sometimes standing still, for up to two seconds
+    bot->dir_x = rand() % 3 - 1;
+    bot->dir_y = rand() % 3 - 1;
+    bot->steps_left = rand() % (2 * input_rate);
+  }
+}
+
+// Sample one input command and send it with the previous few
+static void bot_send_input(Bot *bot) {
+  bot_next_move(bot);
+  input_window_push(&bot->inputs, bot->dir_x, bot->dir_y);
+  if (input_window_is_idle(&bot->inputs)) {
+    return;
+  }
+  unsigned char buffer[INPUT_PACKET_MAX_SIZE];
+  WireWriter w;
+  wire_writer_init(&w, buffer, sizeof(buffer));
+  input_write_packet(&w, bot->inputs.commands, bot->inputs.count);
+  bot_send(bot, w.data, w.size, 0);
+}
+
+// Decode a snapshot so deltas keep resolving, then acknowledge it
+static void bot_handle_snapshot(Bot *bot, const uint8_t *data, size_t length) {
+  WireReader r;
+  wire_reader_init(&r, data, length);
+  Snapshot snapshot;
+  uint32_t baseline_sequence;
+  uint32_t input_ack;
+
+  switch (snapshot_read_packet(&r, bot->snapshots, &snapshot, &baseline_sequence, &input_ack)) {
+  case SNAPSHOT_READ_OK:
+    break;
+  case SNAPSHOT_READ_STALE:
+    return;
+  case SNAPSHOT_READ_NO_BASELINE:
+    totals.missing_baselines++;
+    return;
+  default:
+    totals.malformed++;
+    return;
+  }
+  snapshot_history_store(bot->snapshots, &snapshot);
+  bot->snapshots_received++;
+
+  SnapshotAckPacket ack = {PKT_SNAPSHOT_ACK, snapshot.sequence};
+  bot_send(bot, &ack, sizeof(ack), 0);
+}
+
+static void bot_handle_packet(Bot *bot, const ENetPacket *packet, enet_uint32 now) {
+  bot->bytes_in += packet->dataLength;
+  switch (packet->data[0]) {
+  case PKT_PLAYER_ID: {
+    if (packet->dataLength < sizeof(WelcomePacket)) {
+      break;
+    }
+    const WelcomePacket *welcome = (const WelcomePacket *)packet->data;
+    bot->player_id = welcome->player_id;
+    if (welcome->tick_rate > 0) {
+      input_rate = welcome->tick_rate;
+    }
+    bot->join_ms = now - bot->connect_ms;
+    bot->state = BOT_JOINED;
+    LOG_DEBUG("Bot joined as player %d after %u ms", bot->player_id, bot->join_ms);
+    break;
+  }
+  case PKT_SNAPSHOT:
+    bot_handle_snapshot(bot, packet->data, packet->dataLength);
+    break;
+  case PKT_SERVER_STATS: {
+    WireReader r;
+    wire_reader_init(&r, packet->data, packet->dataLength);
+    have_server_stats = server_stats_read_packet(&r, &server_stats);
+    break;
+  }
+  default:
+    // Map chunks and join/leave notices only count towards bandwidth
+    break;
+  }
+}
+
+static void handle_events(enet_uint32 timeout_ms) {
+  ENetEvent event;
+  int result = enet_host_service(host, &event, timeout_ms);
+  while (result > 0) {
+    Bot *bot = event.peer->data;
+    enet_uint32 now = enet_time_get();
+    switch (event.type) {
+    case ENET_EVENT_TYPE_CONNECT:
+      LOG_TRACE("Bot connected, waiting for a player id");
+      break;
+    case ENET_EVENT_TYPE_RECEIVE:
+      if (bot && event.packet->dataLength > 0) {
+        bot_handle_packet(bot, event.packet, now);
+      }
+      enet_packet_destroy(event.packet);
+      break;
+    case ENET_EVENT_TYPE_DISCONNECT:
+      if (bot) {
+        bot->state = bot->state == BOT_JOINED ? BOT_DROPPED : BOT_REJECTED;
+        bot->peer = NULL;
+        LOG_DEBUG("Bot disconnected (%s)", bot->state == BOT_DROPPED ? "dropped" : "rejected");
+      }
+      break;
+    default:
+      break;
+    }
+    result = enet_host_check_events(host, &event);
+  }
+}
+
+static bool connect_bot(Bot *bot, const ENetAddress *address) {
+  bot->peer = enet_host_connect(host, address, CHANNEL_COUNT, 0);
+  if (!bot->peer) {
+    LOG_ERROR("Failed to start connection");
+    bot->state = BOT_REJECTED;
+    return false;
+  }
+  bot->peer->data = bot;
+  bot->state = BOT_CONNECTING;
+  bot->connect_ms = enet_time_get();
+  return true;
+}
+
+// Print one line for the last report window and reset the window counters
+static void report(double window_s, double elapsed_s) {
+  int joined = 0, rejected = 0, dropped = 0, pending = 0;
+  enet_uint32 join_total = 0, join_max = 0;
+  int snapshots = 0;
+  size_t bytes_in = 0, bytes_out = 0;
+
+  for (int i = 0; i < config.bot_count; i++) {
+    Bot *bot = &bots[i];
+    switch (bot->state) {
+    case BOT_JOINED:
+      joined++;
+      join_total += bot->join_ms;
+      if (bot->join_ms > join_max) {
+        join_max = bot->join_ms;
+      }
+      break;
+    case BOT_REJECTED:
+      rejected++;
+      break;
+    case BOT_DROPPED:
+      dropped++;
+      break;
+    case BOT_CONNECTING:
+      pending++;
+      break;
+    default:
+      break;
+    }
+    snapshots += bot->snapshots_received;
+    bytes_in += bot->bytes_in;
+    bytes_out += bot->bytes_out;
+    bot->snapshots_received = 0;
+    bot->bytes_in = 0;
+    bot->bytes_out = 0;
+  }
+  totals.snapshots += snapshots;
+  totals.bytes_in += bytes_in;
+  totals.bytes_out += bytes_out;
+
+  double per_bot = joined > 0 && window_s > 0 ? 1.0 / (joined * window_s) : 0.0;
+  printf("[%6.1fs] joined %d pending %d rejected %d dropped %d | join ms avg %.1f max %u |"
+         " per bot: %.1f snapshots/s, in %.0f B/s, out %.0f B/s",
+         elapsed_s, joined, pending, rejected, dropped,
+         joined > 0 ? (double)join_total / joined : 0.0, join_max,
+         snapshots * per_bot, bytes_in * per_bot, bytes_out * per_bot);
+  if (have_server_stats) {
+    printf(" | server tick %u players %u ms p50 %.2f p90 %.2f p99 %.2f max %.2f overruns %u",
+           server_stats.tick, server_stats.players, server_stats.tick_p50_us / 1000.0,
+           server_stats.tick_p90_us / 1000.0, server_stats.tick_p99_us / 1000.0,
+           server_stats.tick_max_us / 1000.0, server_stats.overruns);
+  }
+  printf("\n");
+  fflush(stdout);
+}
+
+// Ask the server for its tick timings through any joined bot
+static void request_server_stats(void) {
+  for (int i = 0; i < config.bot_count; i++) {
+    if (bots[i].state == BOT_JOINED) {
+      unsigned char request = PKT_STATS_REQUEST;
+      bot_send(&bots[i], &request, sizeof(request), 0);
+      return;
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (!parse_args(argc, argv)) {
+    exit(1);
+  }
+  log_init();
+  signal(SIGINT, signal_handler);
+  signal(SIGTERM, signal_handler);
+
+  if (enet_initialize() != 0) {
+    LOG_ERROR("ENet initialization failed");
+    exit(1);
+  }
+  host = enet_host_create(NULL, config.bot_count, CHANNEL_COUNT, 0, 0);
+  if (!host) {
+    LOG_ERROR("Failed to create ENet host for %d bots", config.bot_count);
+    enet_deinitialize();
+    exit(1);
+  }
+
+  bots = calloc(config.bot_count, sizeof(Bot));
+  if (!bots) {
+    LOG_ERROR("Failed to allocate %d bots", config.bot_count);
+    enet_host_destroy(host);
+    enet_deinitialize();
+    exit(1);
+  }
+  for (int i = 0; i < config.bot_count; i++) {
+    bots[i].player_id = -1;
+    bots[i].side = -1;
+    bots[i].snapshots = malloc(sizeof(SnapshotHistory));
+    if (!bots[i].snapshots) {
+      LOG_ERROR("Failed to allocate snapshot history for bot %d", i);
+      for (int j = 0; j < i; j++) {
+        free(bots[j].snapshots);
+      }
+      free(bots);
+      enet_host_destroy(host);
+      enet_deinitialize();
+      exit(1);
+    }
+    snapshot_history_reset(bots[i].snapshots);
+    input_window_reset(&bots[i].inputs);
+  }
+
+  ENetAddress address;
+  enet_address_set_host(&address, config.host);
+  address.port = config.port;
+  printf("Connecting %d bots to %s:%d at %d per second, %s movement\n", config.bot_count,
+         config.host, config.port, config.connect_rate,
+         config.mode == MOVE_SQUARE ? "square" : "random");
+
+  enet_uint32 start = enet_time_get();
+  enet_uint32 last_report = start;
+  double input_accumulator = 0.0;
+  enet_uint32 last_frame = start;
+  int connected = 0;
+
+  while (running) {
+    enet_uint32 now = enet_time_get();
+    double elapsed = (now - start) / 1000.0;
+    if (config.duration > 0 && elapsed >= config.duration) {
+      break;
+    }
+
+    // Ramp up connections so the join latency reflects the server, not a burst
+    int due = (int)(elapsed * config.connect_rate) + 1;
+    while (connected < config.bot_count && connected < due) {
+      connect_bot(&bots[connected++], &address);
+    }
+
+    input_accumulator += (now - last_frame) / 1000.0;
+    last_frame = now;
+    while (input_accumulator >= 1.0 / input_rate) {
+      input_accumulator -= 1.0 / input_rate;
+      for (int i = 0; i < config.bot_count; i++) {
+        if (bots[i].state == BOT_JOINED) {
+          bot_send_input(&bots[i]);
+        }
+      }
+    }
+
+    if (now - last_report >= REPORT_INTERVAL_MS) {
+      report((now - last_report) / 1000.0, elapsed);
+      request_server_stats();
+      last_report = now;
+    }
+
+    handle_events(1);
+  }
+
+  double elapsed = (enet_time_get() - start) / 1000.0;
+  report((enet_time_get() - last_report) / 1000.0, elapsed);
+  printf("Total: %d snapshots, %zu bytes in, %zu bytes out over %.1fs;"
+         " %d missing baselines, %d malformed snapshots\n",
+         totals.snapshots, totals.bytes_in, totals.bytes_out, elapsed,
+         totals.missing_baselines, totals.malformed);
+
+  for (int i = 0; i < config.bot_count; i++) {
+    if (bots[i].peer) {
+      enet_peer_disconnect(bots[i].peer, 0);
+    }
+  }
+  enet_host_flush(host);
+  for (int i = 0; i < config.bot_count; i++) {
+    free(bots[i].snapshots);
+  }
+  free(bots);
+  enet_host_destroy(host);
+  enet_deinitialize();
+  log_shutdown();
+  return 0;
+}
@@ -0,0 +1,175 @@
+#include "frame_profiler.h"
+#include <stdio.h>
+#include "raylib.h"
+#include "../../common/src/log.h"
+
+static const char *phase_names[FRAME_PHASE_COUNT] = {"frame", "network", "update", "tiles",
+                                                     "players"};
+
+static bool overlay_visible = false;
+static FILE *trace_file = NULL;
+static const char *trace_path = NULL;
+static uint64_t frame_number = 0;
+
+// Current frame
+static double phase_start[FRAME_PHASE_COUNT];
+static double phase_ms[FRAME_PHASE_COUNT];
+static int frame_packets = 0;
+static size_t frame_bytes = 0;
+static double last_snapshot_time = -1;
+static uint32_t last_rtt_ms = 0;
+
+// Frames since the overlay figures were last refreshed
+static double window_start = 0;
+static int window_frames = 0;
+static double window_sum_ms[FRAME_PHASE_COUNT];
+static double window_max_ms[FRAME_PHASE_COUNT];
+static int window_packets = 0;
+static size_t window_bytes = 0;
+
+// Figures shown by the overlay, refreshed once a second
+static double average_ms[FRAME_PHASE_COUNT];
+static double peak_ms[FRAME_PHASE_COUNT];
+static int packets_per_second = 0;
+static size_t bytes_per_second = 0;
+
+void frame_profiler_begin_frame(void) {
+  for (int i = 0; i < FRAME_PHASE_COUNT; i++) {
+    phase_ms[i] = 0;
+  }
+  frame_packets = 0;
+  frame_bytes = 0;
+  phase_start[FRAME_PHASE_FRAME] = GetTime();
+}
+
+void frame_profiler_begin(FramePhase phase) {
+  phase_start[phase] = GetTime();
+}
+
+// Draw phases only measure submitting the batch; the GPU work shows up in
+// the frame time instead
+void frame_profiler_end(FramePhase phase) {
+  phase_ms[phase] += (GetTime() - phase_start[phase]) * 1000.0;
+}
+
+void frame_profiler_count_packet(size_t bytes) {
+  frame_packets++;
+  frame_bytes += bytes;
+}
+
+void frame_profiler_snapshot_received(void) {
+  last_snapshot_time = GetTime();
+}
+
+// Time since the newest snapshot arrived, -1 before the first one
+static double snapshot_age_ms(double now) {
+  return last_snapshot_time < 0 ? -1 : (now - last_snapshot_time) * 1000.0;
+}
+
+// Close the frame: fold it into the overlay window and append it to the trace
+void frame_profiler_end_frame(uint32_t rtt_ms) {
+  double now = GetTime();
+  frame_profiler_end(FRAME_PHASE_FRAME);
+  last_rtt_ms = rtt_ms;
+  frame_number++;
+
+  window_frames++;
+  window_packets += frame_packets;
+  window_bytes += frame_bytes;
+  for (int i = 0; i < FRAME_PHASE_COUNT; i++) {
+    window_sum_ms[i] += phase_ms[i];
+    if (phase_ms[i] > window_max_ms[i]) {
+      window_max_ms[i] = phase_ms[i];
+    }
+  }
+  if (now - window_start >= 1.0) {
+    double seconds = now - window_start;
+    for (int i = 0; i < FRAME_PHASE_COUNT; i++) {
+      average_ms[i] = window_sum_ms[i] / window_frames;
+      peak_ms[i] = window_max_ms[i];
+      window_sum_ms[i] = 0;
+      window_max_ms[i] = 0;
+    }
+    packets_per_second = (int)(window_packets / seconds);
+    bytes_per_second = (size_t)(window_bytes / seconds);
+    window_start = now;
+    window_frames = 0;
+    window_packets = 0;
+    window_bytes = 0;
+  }
+
+  if (trace_file) {
+    fprintf(trace_file, "%llu,%.3f", (unsigned long long)frame_number, now * 1000.0);
+    for (int i = 0; i < FRAME_PHASE_COUNT; i++) {
+      fprintf(trace_file, ",%.3f", phase_ms[i]);
+    }
+    fprintf(trace_file, ",%d,%zu,%u,%.1f\n", frame_packets, frame_bytes, rtt_ms,
+            snapshot_age_ms(now));
+  }
+}
+
+void frame_profiler_toggle_overlay(void) {
+  overlay_visible = !overlay_visible;
+}
+
+void frame_profiler_draw_overlay(int x, int y) {
+  if (!overlay_visible) {
+    return;
+  }
+  const int font_size = 10;
+  const int line_height = 12;
+  int lines = FRAME_PHASE_COUNT + 4;
+  DrawRectangle(x - 4, y - 4, 230, lines * line_height + 8, (Color){0, 0, 0, 180});
+
+  DrawText(TextFormat("%d fps", GetFPS()), x, y, font_size, WHITE);
+  y += line_height;
+  for (int i = 0; i < FRAME_PHASE_COUNT; i++) {
+    DrawText(TextFormat("%-8s %6.2f ms  max %6.2f", phase_names[i], average_ms[i], peak_ms[i]), x,
+             y, font_size, WHITE);
+    y += line_height;
+  }
+  DrawText(TextFormat("recv %d pkt/s  %.1f KB/s", packets_per_second, bytes_per_second / 1024.0),
+           x, y, font_size, WHITE);
+  y += line_height;
+  DrawText(TextFormat("rtt %u ms  snapshot age %.0f ms", last_rtt_ms, snapshot_age_ms(GetTime())),
+           x, y, font_size, WHITE);
+  y += line_height;
+  DrawText(trace_file ? TextFormat("tracing to %s", trace_path) : "F4 to record a trace", x, y,
+           font_size, trace_file ? RED : LIGHTGRAY);
+}
+
+// Append per-frame rows to a CSV file; the header is written once per file
+bool frame_profiler_start_trace(const char *path) {
+  if (trace_file) {
+    return true;
+  }
+  trace_file = fopen(path, "a");
+  if (!trace_file) {
+    LOG_ERROR("Failed to open profile trace %s", path);
+    return false;
+  }
+  trace_path = path;
+  fseek(trace_file, 0, SEEK_END);
+  if (ftell(trace_file) == 0) {
+    fprintf(trace_file, "frame,time_ms");
+    for (int i = 0; i < FRAME_PHASE_COUNT; i++) {
+      fprintf(trace_file, ",%s_ms", phase_names[i]);
+    }
+    fprintf(trace_file, ",packets,bytes,rtt_ms,snapshot_age_ms\n");
+  }
+  LOG_INFO("Recording profile trace to %s", path);
+  return true;
+}
+
+void frame_profiler_stop_trace(void) {
+  if (!trace_file) {
+    return;
+  }
+  fclose(trace_file);
+  trace_file = NULL;
+  LOG_INFO("Stopped profile trace %s", trace_path);
+}
+
+bool frame_profiler_tracing(void) {
+  return trace_file != NULL;
+}
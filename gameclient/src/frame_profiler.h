@@ -0,0 +1,34 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Trace file used when none is given on the command line
+#define DEFAULT_PROFILE_CSV "client_profile.csv"
+
+// Parts of a client frame that are timed
+typedef enum {
+  FRAME_PHASE_FRAME, // Whole loop iteration, including the wait for vsync
+  FRAME_PHASE_NETWORK,
+  FRAME_PHASE_UPDATE,
+  FRAME_PHASE_TILES,
+  FRAME_PHASE_PLAYERS,
+  FRAME_PHASE_COUNT,
+} FramePhase;
+
+void frame_profiler_begin_frame(void);
+void frame_profiler_end_frame(uint32_t rtt_ms);
+void frame_profiler_begin(FramePhase phase);
+void frame_profiler_end(FramePhase phase);
+void frame_profiler_count_packet(size_t bytes);
+void frame_profiler_snapshot_received(void);
+
+void frame_profiler_toggle_overlay(void);
+void frame_profiler_draw_overlay(int x, int y);
+bool frame_profiler_start_trace(const char *path);
+void frame_profiler_stop_trace(void);
+bool frame_profiler_tracing(void);
+
+#endif // FRAME_PROFILER_H
@@ -3,19 +3,11 @@
 
 #include "../../common/src/common.h"
 
-typedef enum EntityType {
-  ENTITY_PLAYER,
-  ENTITY_BULLET,
-  ENTITY_ENEMY,
-  ENTITY_ITEM,
-} EntityType;
-
 // Player management functions
 void init_players(PlayerMap *map);
-void update_player_positions(PlayerMap *map, const PlayerPositionsPacket *packet);
 void draw_players(PlayerMap *map);
-void set_local_player_id(PlayerMap *map, unsigned char new_player_id, unsigned char color_index);
-void add_remote_player_id(PlayerMap *map, unsigned char player_id, unsigned char color_index);
-void remove_remote_player_id(PlayerMap *map, unsigned char player_id);
+void set_local_player_id(PlayerMap *map, int new_player_id, unsigned char color_index);
+void add_remote_player_id(PlayerMap *map, int player_id, unsigned char color_index);
+void remove_remote_player_id(PlayerMap *map, int player_id);
 
 #endif // GAME_H 
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "interpolation.h"
+#include "../../common/src/log.h"
+
+// Snapshot history of every remote entity, indexed by player id
+static InterpBuffer *buffers = NULL;
+static int buffer_count = 0;
+
+// Estimate of server time as an offset from the local clock, in seconds
+static double clock_offset = 0;
+static bool clock_synced = false;
+static int server_tick_rate = 20;
+static double delay_seconds = DEFAULT_INTERP_DELAY_MS / 1000.0;
+
+// Forget all entity history and resynchronize the clock on the next snapshot.
+// max_players is the server's player capacity; ids are below it.
+void interp_init(int tick_rate, int delay_ms, int max_players) {
+  if (max_players != buffer_count) {
+    InterpBuffer *resized = realloc(buffers, max_players * sizeof(InterpBuffer));
+    if (!resized && max_players > 0) {
+      LOG_ERROR("Failed to allocate interpolation buffers for %d players", max_players);
+      max_players = buffer_count;
+    } else {
+      buffers = resized;
+      buffer_count = max_players;
+    }
+  }
+  if (buffers) {
+    memset(buffers, 0, buffer_count * sizeof(InterpBuffer));
+  }
+  clock_synced = false;
+  server_tick_rate = tick_rate > 0 ? tick_rate : 20;
+  delay_seconds = delay_ms / 1000.0;
+}
+
+// Feed the arrival time of a snapshot into the server clock estimate. Small
+// errors are smoothed out so jitter does not shake the render time; large
+// ones (first snapshot, a stall) snap the clock.
+void interp_clock_sample(uint32_t tick, double local_time) {
+  double offset = (double)tick / server_tick_rate - local_time;
+  double error = offset - clock_offset;
+  if (!clock_synced || error > 0.5 || error < -0.5) {
+    clock_offset = offset;
+    clock_synced = true;
+    return;
+  }
+  clock_offset += error * 0.05;
+}
+
+// Server tick remote entities should be drawn at right now
+double interp_render_tick(double local_time) {
+  return (local_time + clock_offset - delay_seconds) * server_tick_rate;
+}
+
+void interp_reset(int id) {
+  if (id >= 0 && id < buffer_count) {
+    buffers[id].count = 0;
+  }
+}
+
+// Record where the server had an entity at a tick; older ticks are ignored
+void interp_push(int id, uint32_t tick, int x, int y) {
+  if (id < 0 || id >= buffer_count) {
+    return;
+  }
+  InterpBuffer *buffer = &buffers[id];
+  if (buffer->count > 0 && tick <= buffer->ticks[buffer->count - 1]) {
+    return;
+  }
+  if (buffer->count == INTERP_BUFFER_SIZE) {
+    int keep = INTERP_BUFFER_SIZE - 1;
+    memmove(buffer->ticks, buffer->ticks + 1, keep * sizeof(buffer->ticks[0]));
+    memmove(buffer->x, buffer->x + 1, keep * sizeof(buffer->x[0]));
+    memmove(buffer->y, buffer->y + 1, keep * sizeof(buffer->y[0]));
+    buffer->count = keep;
+  }
+  buffer->ticks[buffer->count] = tick;
+  buffer->x[buffer->count] = x;
+  buffer->y[buffer->count] = y;
+  buffer->count++;
+}
+
+// Position of an entity at render_tick: interpolated between the two
+// surrounding snapshots, or extrapolated for a bounded time when the newest
+// one is older than render_tick. Returns false if nothing is known yet.
+bool interp_sample(int id, double render_tick, float *x, float *y) {
+  if (id < 0 || id >= buffer_count || buffers[id].count == 0) {
+    return false;
+  }
+  const InterpBuffer *buffer = &buffers[id];
+  int last = buffer->count - 1;
+
+  if (render_tick <= buffer->ticks[0] || buffer->count == 1) {
+    *x = buffer->x[render_tick <= buffer->ticks[0] ? 0 : last];
+    *y = buffer->y[render_tick <= buffer->ticks[0] ? 0 : last];
+    return true;
+  }
+
+  for (int i = 0; i < last; i++) {
+    if (render_tick < buffer->ticks[i + 1]) {
+      float t = (float)((render_tick - buffer->ticks[i]) / (buffer->ticks[i + 1] - buffer->ticks[i]));
+      *x = buffer->x[i] + (buffer->x[i + 1] - buffer->x[i]) * t;
+      *y = buffer->y[i] + (buffer->y[i + 1] - buffer->y[i]) * t;
+      return true;
+    }
+  }
+
+  // Late: keep going at the last known velocity, but not for long
+  double ahead = render_tick - buffer->ticks[last];
+  double max_ahead = INTERP_MAX_EXTRAPOLATION_MS / 1000.0 * server_tick_rate;
+  if (ahead > max_ahead) {
+    ahead = max_ahead;
+  }
+  double span = buffer->ticks[last] - buffer->ticks[last - 1];
+  *x = buffer->x[last] + (float)((buffer->x[last] - buffer->x[last - 1]) / span * ahead);
+  *y = buffer->y[last] + (float)((buffer->y[last] - buffer->y[last - 1]) / span * ahead);
+  return true;
+}
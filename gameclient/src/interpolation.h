@@ -0,0 +1,30 @@
+#ifndef INTERPOLATION_H
+#define INTERPOLATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../../common/src/common.h"
+
+// Positions kept per remote entity; must cover the delay at the highest tick rate
+#define INTERP_BUFFER_SIZE 16
+// How far behind the estimated server time remote entities are drawn
+#define DEFAULT_INTERP_DELAY_MS 100
+// Longest time a remote entity keeps moving past its newest position
+#define INTERP_MAX_EXTRAPOLATION_MS 100
+
+// Server positions of one entity, oldest first
+typedef struct {
+  uint32_t ticks[INTERP_BUFFER_SIZE];
+  int x[INTERP_BUFFER_SIZE];
+  int y[INTERP_BUFFER_SIZE];
+  int count;
+} InterpBuffer;
+
+void interp_init(int tick_rate, int delay_ms, int max_players);
+void interp_clock_sample(uint32_t tick, double local_time);
+double interp_render_tick(double local_time);
+void interp_reset(int id);
+void interp_push(int id, uint32_t tick, int x, int y);
+bool interp_sample(int id, double render_tick, float *x, float *y);
+
+#endif // INTERPOLATION_H
@@ -1,15 +1,30 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "frame_profiler.h"
 #include "game.h"
+#include "interpolation.h"
 #include "network.h"
+#include "prediction.h"
+#include "tilemap.h"
+#include "tile_renderer.h"
 #include "raylib.h"
+#include "../../common/src/input.h"
+#include "../../common/src/log.h"
 
 // Global
-Tile current_tiles[VIEWPORT_WIDTH][VIEWPORT_HEIGHT];
+// Camera that keeps the local player centered on screen
+Camera2D camera = {0};
 // Use the PlayerMap from common.h
 PlayerMap player_map = {0};
 int local_player_id = -1;
+// Local player position, run ahead of the server by unacknowledged input
+Prediction local_prediction;
+// How far in the past remote players are drawn
+int interp_delay_ms = DEFAULT_INTERP_DELAY_MS;
+// Where F4 records the frame profile
+const char *profile_csv_path = DEFAULT_PROFILE_CSV;
 extern ENetPeer *peer;  // Add extern declaration for peer
 
 // Player colors based on server assignment
@@ -24,61 +39,93 @@ const Color PLAYER_COLORS[8] = {
     {135, 206, 235, 255}  // SKYBLUE
 };
 
-// Initialize players array
+// Empty the player map
 void init_players(PlayerMap *map) {
-  for (int i = 0; i < MAX_PLAYERS; i++) {
-    map->entries[i].player.active = false;
-    map->entries[i].player.x = 0;
-    map->entries[i].player.y = 0;
-    map->entries[i].player.id = -1;
-    map->entries[i].player.color_index = 0; // Default color index
-  }
+  free(map->entries);
+  map->entries = NULL;
   map->count = 0;
+  map->capacity = 0;
 }
 
-// Update player positions based on server data
-void update_player_positions(PlayerMap *map, const PlayerPositionsPacket *packet) {
-  printf("Updating player positions from server packet\n");
-  for (int i = 0; i < packet->player_count; i++) {
-    int id = packet->players[i].id;
-    printf("Processing position update for player %d: (%d, %d)\n", 
-           id, packet->players[i].x, packet->players[i].y);
-    
-    for (int j = 0; j < map->count; j++) {
-      if (map->entries[j].player.id == id) {
-        map->entries[j].player.x = packet->players[i].x;
-        map->entries[j].player.y = packet->players[i].y;
-        printf("Updated player %d position to (%d, %d)\n", 
-               id, map->entries[j].player.x, map->entries[j].player.y);
-        break;
-      }
+// Append a cleared entry, growing the map when it is full
+static Player *append_player(PlayerMap *map) {
+  if (map->count == map->capacity) {
+    int capacity = map->capacity > 0 ? map->capacity * 2 : DEFAULT_MAX_PLAYERS;
+    PeerPlayerEntry *entries = realloc(map->entries, capacity * sizeof(PeerPlayerEntry));
+    if (!entries) {
+      LOG_ERROR("Failed to grow player map to %d players", capacity);
+      return NULL;
     }
+    map->entries = entries;
+    map->capacity = capacity;
   }
-  printf("Updated positions - Active players: ");
+  PeerPlayerEntry *entry = &map->entries[map->count++];
+  memset(entry, 0, sizeof(*entry));
+  return &entry->player;
+}
+
+// Apply a reconstructed server snapshot to the known players.
+// Players missing from it are outside our area of interest and are hidden.
+void apply_snapshot(PlayerMap *map, const Snapshot *snapshot) {
   for (int i = 0; i < map->count; i++) {
-    if (map->entries[i].player.active) {
-      printf("P%d(%d,%d) ", map->entries[i].player.id, 
-             map->entries[i].player.x, map->entries[i].player.y);
+    Player *player = &map->entries[i].player;
+    if (!player->active) {
+      continue;
+    }
+    const SnapshotEntity *entity = snapshot_find_entity(snapshot, player->id);
+    bool in_view = entity != NULL || player->id == local_player_id;
+    if (in_view != player->in_view) {
+      LOG_DEBUG("Player %d %s view", player->id, in_view ? "entered" : "left");
+      player->in_view = in_view;
+      // Don't slide in from wherever it was last seen
+      interp_reset(player->id);
+    }
+    // The local player is predicted; see reconcile_local_player()
+    if (entity && player->id != local_player_id) {
+      player->x = entity->x;
+      player->y = entity->y;
+      interp_push(player->id, snapshot->sequence, entity->x, entity->y);
+    }
+  }
+}
+
+// Copy the predicted position onto the local player
+static void sync_local_player(void) {
+  for (int i = 0; i < player_map.count; i++) {
+    if (player_map.entries[i].player.id == local_player_id && player_map.entries[i].player.active) {
+      player_map.entries[i].player.x = local_prediction.x;
+      player_map.entries[i].player.y = local_prediction.y;
+      break;
     }
   }
-  printf("\n");
+}
+
+// Rewind the local player to the server's position and replay the inputs
+// the server had not processed when it built the snapshot
+void reconcile_local_player(const Snapshot *snapshot, uint32_t input_ack) {
+  const SnapshotEntity *entity = snapshot_find_entity(snapshot, local_player_id);
+  if (local_player_id < 0 || !entity) {
+    return;
+  }
+  prediction_reconcile(&local_prediction, input_ack, entity->x, entity->y);
+  sync_local_player();
 }
 
 // Draw all active players
 void draw_players(PlayerMap *map) {
-  printf("Drawing players. Local player ID: %d\n", local_player_id);
+  LOG_TRACE("Drawing players. Local player ID: %d", local_player_id);
   int active_count = 0;
   for (int i = 0; i < map->count; i++) {
-    if (!map->entries[i].player.active) {
+    if (!map->entries[i].player.active || !map->entries[i].player.in_view) {
       continue;
     }
     active_count++;
-    printf("Drawing player %d at position (%d, %d) with color %d\n",
-           map->entries[i].player.id, map->entries[i].player.x, map->entries[i].player.y, map->entries[i].player.color_index);
+    LOG_TRACE("Drawing player %d at position (%.2f, %.2f) with color %d",
+              map->entries[i].player.id, map->entries[i].player.draw_x, map->entries[i].player.draw_y, map->entries[i].player.color_index);
 
     Color player_color = PLAYER_COLORS[map->entries[i].player.color_index % 8];
-    int screen_x = map->entries[i].player.x * TILE_SIZE;
-    int screen_y = map->entries[i].player.y * TILE_SIZE;
+    int screen_x = (int)(map->entries[i].player.draw_x * TILE_SIZE);
+    int screen_y = (int)(map->entries[i].player.draw_y * TILE_SIZE);
 
     DrawRectangle(screen_x + 2, screen_y + 2, TILE_SIZE, TILE_SIZE, (Color){0, 0, 0, 100});
     DrawRectangle(screen_x, screen_y, TILE_SIZE, TILE_SIZE, player_color);
@@ -112,102 +159,46 @@ void draw_players(PlayerMap *map) {
       DrawText(other_text, other_x, other_y, 15, WHITE);
     }
   }
-  printf("Drew %d active players\n", active_count);
-}
-
-// Handle a tile chunk from the server
-void handle_tile_chunk(const TileChunkPacket *pkt) {
-  printf("Received tile chunk at position (%d, %d)\n", pkt->chunk_x,
-         pkt->chunk_y);
-
-  // Calculate the starting position in the current_tiles array
-  int start_x = pkt->chunk_x * CHUNK_SIZE;
-  int start_y = pkt->chunk_y * CHUNK_SIZE;
-
-  // Copy the tiles from the packet to the current_tiles array
-  for (int y = 0; y < CHUNK_SIZE; y++) {
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-      int tile_x = start_x + x;
-      int tile_y = start_y + y;
-      // Only copy if the tile is within the viewport bounds
-      if (tile_x >= 0 && tile_x < VIEWPORT_WIDTH && tile_y >= 0 &&
-          tile_y < VIEWPORT_HEIGHT) {
-        current_tiles[tile_x][tile_y] = pkt->tiles[y * CHUNK_SIZE + x];
-
-        printf("TILE LOG %d", current_tiles[tile_x][tile_y].tile_id);
-      }
-    }
-  }
-
-  printf("Updated %d tiles in chunk (%d, %d)\n", CHUNK_SIZE * CHUNK_SIZE,
-         pkt->chunk_x, pkt->chunk_y);
+  LOG_TRACE("Drew %d active players", active_count);
 }
 
-void draw_tiles() {
-  printf("Drawing tiles\n");
-  int tile_count = 0;
-  for (int y = 0; y < VIEWPORT_HEIGHT; y++) {
-    for (int x = 0; x < VIEWPORT_WIDTH; x++) {
-      tile_count++;
-      Color col = GRAY; // Default color
-      // Set color based on tile_id
-      switch (current_tiles[x][y].tile_id) {
-      case 0: // Empty/void
-        col = BLACK;
-        break;
-      case 1: // Grass
-        col = DARKGREEN;
-        break;
-      case 2: // Water
-        col = BLUE;
-        break;
-      case 3: // Sand
-        col = YELLOW;
-        break;
-      case 4: // Stone
-        col = DARKGRAY;
-        break;
-      default:
-        col = PURPLE; // Unknown tile type
-        break;
-      }
-      printf("Drawing tile %d at position (%d, %d) with color %d\n", current_tiles[x][y].tile_id, x, y, col);
-      printf("Tile ID: %d\n", current_tiles[x][y].tile_id);
-      printf("Tile walkable: %d\n", current_tiles[x][y].walkable);
-
-      // Draw the tile
-      DrawRectangle(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE, col);
-
-      // Draw a grid line
-      DrawRectangleLines(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE,
-                         (Color){50, 50, 50, 100});
+// Center the camera on the local player
+void update_camera() {
+  camera.offset = (Vector2){GetScreenWidth() / 2.0f, GetScreenHeight() / 2.0f};
+  camera.zoom = 1.0f;
+  for (int i = 0; i < player_map.count; i++) {
+    if (player_map.entries[i].player.id == local_player_id && player_map.entries[i].player.active) {
+      camera.target = (Vector2){player_map.entries[i].player.x * TILE_SIZE + TILE_SIZE / 2.0f,
+                                player_map.entries[i].player.y * TILE_SIZE + TILE_SIZE / 2.0f};
+      break;
     }
   }
-
-  printf("Drew %d tiles\n", tile_count);
 }
 
 int get_local_player_id() {
     return local_player_id;
 }
 // Set the local player ID and color
-void set_local_player_id(PlayerMap *map, unsigned char new_player_id, unsigned char color_index) {
-  printf("Setting local player ID to %d with color %d\n", new_player_id, color_index);
-  local_player_id = (int)new_player_id;
+void set_local_player_id(PlayerMap *map, int new_player_id, unsigned char color_index) {
+  LOG_INFO("Setting local player ID to %d with color %d", new_player_id, color_index);
+  local_player_id = new_player_id;
+  prediction_reset(&local_prediction);
   bool found = false;
   for (int i = 0; i < map->count; i++) {
     if (map->entries[i].player.id == local_player_id) {
       map->entries[i].player.color_index = (int)color_index;
       map->entries[i].player.active = true;
+      map->entries[i].player.in_view = true;
       found = true;
       break;
     }
   }
-  if (!found && map->count < MAX_PLAYERS) {
-    map->entries[map->count].player.id = local_player_id;
-    map->entries[map->count].player.color_index = (int)color_index;
-    map->entries[map->count].player.active = true;
-    map->count++;
+  Player *player = found ? NULL : append_player(map);
+  if (player) {
+    player->id = local_player_id;
+    player->color_index = color_index;
+    player->active = true;
+    player->in_view = true;
   }
 }
 
@@ -221,99 +212,111 @@ bool init_window() {
 
 // Update game state with delta time
 void update_game_state(double delta_time) {
-  // Update player positions based on received position updates
+  // Remote players are drawn a little in the past, between two snapshots
+  double render_tick = interp_render_tick(enet_time_get() / 1000.0);
   for (int i = 0; i < player_map.count; i++) {
-    if (player_map.entries[i].player.active) {
-      // For local player, we apply movement locally
-      if (player_map.entries[i].player.id == local_player_id) {
-        // Movement is handled in the main loop
-      }
-      // For other players, positions are updated from network packets
+    Player *player = &player_map.entries[i].player;
+    if (!player->active) {
+      continue;
+    }
+    // The local player is drawn where prediction put it
+    if (player->id == local_player_id ||
+        !interp_sample(player->id, render_tick, &player->draw_x, &player->draw_y)) {
+      player->draw_x = player->x;
+      player->draw_y = player->y;
     }
   }
 }
 
-// Apply movement locally and send to server
+// Predict one input command locally and send it to the server
 void handle_movement(int dir_x, int dir_y) {
-  printf("Handling movement: dir_x=%d, dir_y=%d\n", dir_x, dir_y);
-  
-  // Find local player
-  for (int i = 0; i < player_map.count; i++) {
-    if (player_map.entries[i].player.id == local_player_id && player_map.entries[i].player.active) {
-      printf("Found local player at position (%d, %d)\n", 
-             player_map.entries[i].player.x, 
-             player_map.entries[i].player.y);
-      
-      // Calculate new position
-      int new_x = player_map.entries[i].player.x + dir_x;
-      int new_y = player_map.entries[i].player.y + dir_y;
-
-      // Check if the new position is within bounds
-      if (new_x >= 0 && new_x < VIEWPORT_WIDTH && new_y >= 0 && new_y < VIEWPORT_HEIGHT) {
-        // Check if the tile is walkable
-        if (current_tiles[new_x][new_y].walkable) {
-          // Apply movement locally
-          player_map.entries[i].player.x = new_x;
-          player_map.entries[i].player.y = new_y;
-          printf("Applied local movement to position (%d, %d)\n", new_x, new_y);
-
-          // Send movement to server
-          MovePacket move_pkt;
-          move_pkt.type = PKT_MOVE;
-          move_pkt.dir_x = dir_x;
-          move_pkt.dir_y = dir_y;
-          ENetPacket *epkt = enet_packet_create(&move_pkt, sizeof(move_pkt), ENET_PACKET_FLAG_RELIABLE);
-          if (enet_peer_send(peer, 0, epkt) < 0) {
-            printf("Failed to send movement packet to server\n");
-          } else {
-            printf("Sent movement packet to server: dir_x=%d, dir_y=%d\n", dir_x, dir_y);
-          }
-        } else {
-          printf("Cannot move to non-walkable tile at (%d, %d)\n", new_x, new_y);
-        }
-      } else {
-        printf("Cannot move out of bounds: (%d, %d)\n", new_x, new_y);
-      }
-      break;
-    }
+  // Idle commands are sent too; they keep the sequence in step with the server's ticks
+  InputCommand command;
+  if (!send_input(dir_x, dir_y, &command)) {
+    LOG_WARN("Failed to send input packet to server");
+  }
+  prediction_apply(&local_prediction, &command);
+  sync_local_player();
+  if (dir_x != 0 || dir_y != 0) {
+    LOG_TRACE("Input %u: dir_x=%d, dir_y=%d, predicted position (%d, %d)", command.sequence,
+              dir_x, dir_y, local_prediction.x, local_prediction.y);
   }
 }
 
 int main(int argc, char *argv[]) {
+  bool trace_at_start = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc && log_parse_level(argv[i + 1]) >= 0) {
+      log_set_level(log_parse_level(argv[++i]));
+    } else if (strcmp(argv[i], "--interp-delay") == 0 && i + 1 < argc && atoi(argv[i + 1]) >= 0) {
+      interp_delay_ms = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--profile-csv") == 0 && i + 1 < argc) {
+      profile_csv_path = argv[++i];
+      trace_at_start = true;
+    } else {
+      printf("Usage: %s [--log-level <trace|debug|info|warn|error|off>] [--interp-delay <ms>] "
+             "[--profile-csv <path>]\n", argv[0]);
+      return 1;
+    }
+  }
+  // Keep log output off the render thread
+  log_init();
+
   // Initialize network
   if (!init_network()) {
-    printf("Failed to initialize network\n");
+    LOG_ERROR("Failed to initialize network");
     return 1;
   }
 
   // Connect to server
   if (!connect_to_server("localhost", 8081)) {
-    printf("Failed to connect to server\n");
+    LOG_ERROR("Failed to connect to server");
     return 1;
   }
 
   // Initialize players
   init_players(&player_map);
 
-  // Initialize tile array
-  memset(current_tiles, 0, sizeof(current_tiles));
+  // Start with no chunks loaded; the server streams them in
+  tilemap_clear();
 
   // Initialize window
   if (!init_window()) {
-    printf("Failed to initialize window\n");
+    LOG_ERROR("Failed to initialize window");
     return 1;
   }
+  if (trace_at_start) {
+    frame_profiler_start_trace(profile_csv_path);
+  }
 
   // Initialize last update time
   double last_update_time = GetTime();
   const double update_interval = 1.0 / 60.0; // 60 updates per second
+  // Input is sampled once per server tick, independent of the frame rate
+  double input_accumulator = 0;
 
   while (!WindowShouldClose()) {
+    frame_profiler_begin_frame();
+    // F3 shows the profiler, F4 starts and stops the CSV trace
+    if (IsKeyPressed(KEY_F3)) {
+      frame_profiler_toggle_overlay();
+    }
+    if (IsKeyPressed(KEY_F4)) {
+      if (frame_profiler_tracing()) {
+        frame_profiler_stop_trace();
+      } else {
+        frame_profiler_start_trace(profile_csv_path);
+      }
+    }
     double current_time = GetTime();
     double delta_time = current_time - last_update_time;
     last_update_time = current_time;
-    {
-      
+    input_accumulator += delta_time;
+    double input_interval = 1.0 / get_server_tick_rate();
+    if (input_accumulator >= input_interval) {
+      // After a long frame send one command rather than a burst
+      input_accumulator = input_accumulator >= 2 * input_interval ? 0 : input_accumulator - input_interval;
+
       // Handle input and movement
       int dir_x = 0;
       int dir_y = 0;
@@ -322,33 +325,49 @@ int main(int argc, char *argv[]) {
       if (IsKeyDown(KEY_LEFT)) dir_x = -1;
       if (IsKeyDown(KEY_DOWN)) dir_y = 1;
        if (IsKeyDown(KEY_UP)) dir_y = -1;
-      // Only handle movement if there's actual movement
-      if (dir_x != 0 || dir_y != 0) {
-        printf("Movement tiles\n");
+      // Input only counts once the server has given us a player
+      if (local_player_id >= 0) {
         handle_movement(dir_x, dir_y);
       }
     }
     // Handle network events
+    frame_profiler_begin(FRAME_PHASE_NETWORK);
     handle_network();
+    frame_profiler_end(FRAME_PHASE_NETWORK);
 
     // Update game state
+    frame_profiler_begin(FRAME_PHASE_UPDATE);
     update_game_state(delta_time);
+    update_camera();
+    frame_profiler_end(FRAME_PHASE_UPDATE);
+    // Re-render chunks that changed before the camera transform is active
+    frame_profiler_begin(FRAME_PHASE_TILES);
+    tile_renderer_update(&camera);
+    frame_profiler_end(FRAME_PHASE_TILES);
 
     // Draw game
     BeginDrawing();
     ClearBackground(RAYWHITE);
 
-    // Draw tiles
-    draw_tiles();
+    BeginMode2D(camera);
+    // Draw tiles from the cached chunk textures
+    frame_profiler_begin(FRAME_PHASE_TILES);
+    tile_renderer_draw(&camera);
+    frame_profiler_end(FRAME_PHASE_TILES);
     // Draw players
+    frame_profiler_begin(FRAME_PHASE_PLAYERS);
     draw_players(&player_map);
+    frame_profiler_end(FRAME_PHASE_PLAYERS);
+    EndMode2D();
     // Draw connection status
     if (!is_connected()) {
       DrawText("Connecting to server...", 10, 10, 20, RED);
       DrawText("Press ESC to quit", 10, 40, 20, RED);
     }
+    frame_profiler_draw_overlay(10, 70);
 
     EndDrawing();
+    frame_profiler_end_frame(is_connected() ? peer->roundTripTime : 0);
 
     // Check for window close
     if (WindowShouldClose()) {
@@ -357,13 +376,16 @@ int main(int argc, char *argv[]) {
   }
   // Cleanup
   disconnect();
+  tile_renderer_unload();
+  frame_profiler_stop_trace();
   CloseWindow();
+  log_shutdown();
   return 0;
 }
 
 // Add a remote player
-void add_remote_player_id(PlayerMap *map, unsigned char player_id, unsigned char color_index) {
-  int new_player_id = (int)player_id;
+void add_remote_player_id(PlayerMap *map, int player_id, unsigned char color_index) {
+  int new_player_id = player_id;
   if (new_player_id == local_player_id) return;
 
   // Check if the player is already in the map
@@ -371,19 +393,35 @@ void add_remote_player_id(PlayerMap *map, unsigned char player_id, unsigned char
     if (map->entries[i].player.id == new_player_id) {
       map->entries[i].player.color_index = color_index;
       map->entries[i].player.active = true;
-      printf("Updated existing player %d in map\n", new_player_id);
+      LOG_DEBUG("Updated existing player %d in map", new_player_id);
       return;
     }
   }
+  // Reuse a slot freed by a removed player before growing the map
+  for (int i = 0; i < map->count; i++) {
+    if (!map->entries[i].player.active && map->entries[i].player.id == -1) {
+      map->entries[i].player.id = new_player_id;
+      map->entries[i].player.color_index = color_index;
+      map->entries[i].player.active = true;
+      return;
+    }
+  }
+  Player *player = append_player(map);
+  if (player) {
+    player->id = new_player_id;
+    player->color_index = color_index;
+    player->active = true;
+  }
 }
 
 // Remove a remote player
-void remove_remote_player_id(PlayerMap *map, unsigned char player_id) {
-  int new_player_id = (int)player_id;
+void remove_remote_player_id(PlayerMap *map, int player_id) {
+  int new_player_id = player_id;
   if (new_player_id == local_player_id) return;
   for (int i = 0; i < map->count; i++) {
     if (map->entries[i].player.id == new_player_id) {
       map->entries[i].player.active = false;
+      map->entries[i].player.in_view = false;
       map->entries[i].player.id = -1;
       map->entries[i].player.color_index = -1;
       map->entries[i].player.x = 0;
@@ -3,7 +3,15 @@
 #include <string.h>
 #include <stdint.h>
 #include "network.h"
+#include "frame_profiler.h"
+#include "interpolation.h"
+#include "tilemap.h"
+#include "../../common/src/chunk_codec.h"
 #include "../../common/src/common.h"
+#include "../../common/src/input.h"
+#include "../../common/src/log.h"
+#include "../../common/src/packet_pool.h"
+#include "../../common/src/snapshot.h"
 
 // Global variables
 ENetHost *client;
@@ -14,14 +22,20 @@ ENetPeer *peer;
 bool connected = false;
 bool connection_confirmed = false;
 int connection_timeout = 60; // 60 frames timeout for connection
+// Snapshots received from the server, kept as delta baselines
+SnapshotHistory received_snapshots;
+// Newest input commands; each input packet repeats all of them
+InputWindow recent_inputs = {{{0}}, 0, 1};
+// Server tick rate from the welcome packet; input is sampled at this rate
+static int server_tick_rate = INPUT_RATE;
 
-// External function to update player positions in the game
-extern void update_player_positions(PlayerMap *map, const PlayerPositionsPacket *pkt);
+// External function to apply a full snapshot to the game
+extern void apply_snapshot(PlayerMap *map, const Snapshot *snapshot);
 // External function to set the local player ID
-extern void set_local_player_id(PlayerMap *map, unsigned char new_player_id, unsigned char color_index);
+extern void set_local_player_id(PlayerMap *map, int new_player_id, unsigned char color_index);
 extern int get_local_player_id();
-// External variable for current tiles
-extern Tile current_tiles[VIEWPORT_WIDTH][VIEWPORT_HEIGHT];
+// Interpolation delay for remote players, set from the command line
+extern int interp_delay_ms;
 // External variable for player map
 extern PlayerMap player_map;
 
@@ -30,13 +44,13 @@ bool init_network()
 {
     if (enet_initialize() != 0)
     {
-        printf("ENet initialization failed\n");
+        LOG_ERROR("ENet initialization failed");
         return false;
     }
-    client = enet_host_create(NULL, 1, 2, 0, 0);
+    client = enet_host_create(NULL, 1, CHANNEL_COUNT, 0, 0);
     if (client == NULL)
     {
-        printf("Failed to create ENet host\n");
+        LOG_ERROR("Failed to create ENet host");
         enet_deinitialize();
         return false;
     }
@@ -47,19 +61,73 @@ bool connect_to_server(const char *host, int port)
 {
     address.port = port;
     enet_address_set_host(&address, host);
-    peer = enet_host_connect(client, &address, 2, 0);
+    peer = enet_host_connect(client, &address, CHANNEL_COUNT, 0);
     if (peer == NULL)
     {
-        printf("Failed to connect to server\n");
+        LOG_ERROR("Failed to connect to server");
         return false;
     }
-    printf("Connecting to server...\n");
+    LOG_INFO("Connecting to server...");
     connected = true;
     connection_confirmed = false;
     connection_timeout = 60; // Reset timeout
+    snapshot_history_reset(&received_snapshots);
+    input_window_reset(&recent_inputs);
+    tilemap_clear();
     return true;
 }
 
+// Rebuild a snapshot from its delta, apply it and acknowledge it
+void handle_snapshot(const uint8_t *data, size_t length)
+{
+    WireReader r;
+    wire_reader_init(&r, data, length);
+    Snapshot snapshot;
+    uint32_t baseline_sequence;
+    uint32_t input_ack;
+    uint32_t sequence;
+
+    switch (snapshot_read_packet(&r, &received_snapshots, &snapshot, &baseline_sequence, &input_ack))
+    {
+    case SNAPSHOT_READ_OK:
+        break;
+    case SNAPSHOT_READ_STALE:
+        // Ignore anything older than the snapshot we already applied
+        return;
+    case SNAPSHOT_READ_NO_BASELINE:
+        LOG_WARN("Missing baseline %u for snapshot %u", baseline_sequence, snapshot.sequence);
+        return;
+    default:
+        LOG_WARN("Malformed snapshot %u", snapshot.sequence);
+        return;
+    }
+    sequence = snapshot.sequence;
+    frame_profiler_snapshot_received();
+    interp_clock_sample(sequence, enet_time_get() / 1000.0);
+    snapshot_history_store(&received_snapshots, &snapshot);
+    apply_snapshot(&player_map, &snapshot);
+    reconcile_local_player(&snapshot, input_ack);
+
+    SnapshotAckPacket ack = {PKT_SNAPSHOT_ACK, sequence};
+    ENetPacket *epkt = packet_pool_create(&ack, sizeof(ack), 0);
+    if (epkt && enet_peer_send(peer, CHANNEL_STATE, epkt) != 0)
+    {
+        enet_packet_destroy(epkt);
+    }
+}
+
+// Ask the server to resend a chunk we lost track of
+static void request_chunk(int chunk_x, int chunk_y)
+{
+    LOG_DEBUG("Requesting chunk (%d, %d) again", chunk_x, chunk_y);
+    ChunkRequestPacket request = {PKT_CHUNK_REQUEST, chunk_x, chunk_y};
+    ENetPacket *epkt = packet_pool_create(&request, sizeof(request), ENET_PACKET_FLAG_RELIABLE);
+    if (epkt && enet_peer_send(peer, CHANNEL_RELIABLE, epkt) != 0)
+    {
+        enet_packet_destroy(epkt);
+    }
+}
+
 void handle_network()
 {
     ENetEvent event;
@@ -68,12 +136,13 @@ void handle_network()
         switch (event.type)
         {
             case ENET_EVENT_TYPE_CONNECT:
-                printf("Connected to server\n");
+                LOG_INFO("Connected to server");
                 connected = true;
                 connection_confirmed = true;
                 break;
 
             case ENET_EVENT_TYPE_RECEIVE:
+                frame_profiler_count_packet(event.packet->dataLength);
                 // Process the packet
                 uint8_t packet_type = *(uint8_t *)event.packet->data;
                 switch (packet_type)
@@ -82,93 +151,146 @@ void handle_network()
                 case PKT_ADD_PLAYER:
                 {
                     PlayerIdPacket *add_packet = (PlayerIdPacket *)event.packet->data;
-                    printf("Received player add %d \n", add_packet->player_id);
-                    printf("Local player id %d \n", get_local_player_id());
+                    LOG_DEBUG("Received player add %d", add_packet->player_id);
+                    LOG_DEBUG("Local player id %d", get_local_player_id());
                     if (add_packet->player_id == get_local_player_id()) break;
                     add_remote_player_id(&player_map, add_packet->player_id, add_packet->color_index);
+                    // The player's first snapshot may have overtaken this packet
+                    const Snapshot *latest = snapshot_history_find(&received_snapshots, received_snapshots.last_sequence);
+                    if (latest) apply_snapshot(&player_map, latest);
                     break;
                 }
                 case PKT_REMOVE_PLAYER:
                     {
                         PlayerIdPacket *remove_packet = (PlayerIdPacket *)event.packet->data;   
-                        printf("Received player remove %d \n", remove_packet->player_id);    
-                        printf("Local player id %d \n", get_local_player_id());
+                        LOG_DEBUG("Received player remove %d", remove_packet->player_id);
+                        LOG_DEBUG("Local player id %d", get_local_player_id());
                         remove_remote_player_id(&player_map, remove_packet->player_id);
                         break;
                     }
                 case PKT_PLAYER_ID:
                 {
-                    printf("Received player id\n");
-                    PlayerIdPacket *id_packet = (PlayerIdPacket *)event.packet->data;
+                    LOG_DEBUG("Received player id");
+                    WelcomePacket *id_packet = (WelcomePacket *)event.packet->data;
+                    interp_init(id_packet->tick_rate, interp_delay_ms, id_packet->max_players);
+                    server_tick_rate = id_packet->tick_rate > 0 ? id_packet->tick_rate : INPUT_RATE;
                     set_local_player_id(&player_map, id_packet->player_id, id_packet->color_index);
-                    printf("Received player ID: %d, color: %d\n",
-                           id_packet->player_id, id_packet->color_index);
+                    LOG_INFO("Received player ID: %d, color: %d",
+                             id_packet->player_id, id_packet->color_index);
                     connection_confirmed = true;
                     connected = true;
                     break;
                 }
                 case PKT_TILE_CHUNK:
                 {
-                    TileChunkPacket *chunk = (TileChunkPacket *)event.packet->data;
-                    printf("Received tile chunk at (%d, %d)\n", chunk->chunk_x, chunk->chunk_y);
-                    // Calculate the starting position in the current_tiles array
-                    int start_x = chunk->chunk_x * CHUNK_SIZE;
-                    int start_y = chunk->chunk_y * CHUNK_SIZE;
-                    //TODO:(marcius) Move this to function
-                    // Copy the tiles from the packet to the current_tiles array
-                    for (int y = 0; y < CHUNK_SIZE; y++)
+                    int chunk_x, chunk_y;
+                    uint32_t version;
+                    unsigned char tile_ids[CHUNK_TILE_COUNT];
+                    WireReader r;
+                    wire_reader_init(&r, event.packet->data, event.packet->dataLength);
+                    if (!tile_chunk_read_packet(&r, &chunk_x, &chunk_y, &version, tile_ids))
                     {
-                        for (int x = 0; x < CHUNK_SIZE; x++)
-                        {
-                            int tile_x = start_x + x;
-                            int tile_y = start_y + y;
-
-                            // Only copy if the tile is within the viewport bounds
-                            if (tile_x >= 0 && tile_x < VIEWPORT_WIDTH && tile_y >= 0 && tile_y < VIEWPORT_HEIGHT)
-                            {
-
-                                current_tiles[tile_x][tile_y].tile_id = chunk->tiles[y * CHUNK_SIZE + x].tile_id;
-                                current_tiles[tile_x][tile_y].walkable = chunk->tiles[y * CHUNK_SIZE + x].walkable;
-                            }
-                        }
+                        LOG_WARN("Malformed tile chunk (%zu bytes)", event.packet->dataLength);
+                        break;
                     }
+                    LOG_DEBUG("Received tile chunk at (%d, %d), %zu bytes", chunk_x, chunk_y,
+                              event.packet->dataLength);
+                    tilemap_store_chunk(chunk_x, chunk_y, version, tile_ids);
                     break;
                 }
-                case PKT_PLAYER_POSITIONS:
+                case PKT_TILE_DELTA:
                 {
-                    printf("Received player positions packet\n");
-                    PlayerPositionsPacket *pos = (PlayerPositionsPacket *)event.packet->data;
-                    update_player_positions(&player_map, pos);
+                    int chunk_x, chunk_y, count;
+                    uint32_t version;
+                    TileChange changes[CHUNK_TILE_COUNT];
+                    WireReader r;
+                    wire_reader_init(&r, event.packet->data, event.packet->dataLength);
+                    if (!tile_delta_read_packet(&r, &chunk_x, &chunk_y, &version, changes, &count))
+                    {
+                        LOG_WARN("Malformed tile delta (%zu bytes)", event.packet->dataLength);
+                        break;
+                    }
+                    if (!tilemap_apply_delta(chunk_x, chunk_y, version, changes, count))
+                    {
+                        request_chunk(chunk_x, chunk_y);
+                    }
+                    break;
+                }
+                case PKT_UNLOAD_CHUNK:
+                {
+                    if (event.packet->dataLength < sizeof(ChunkUnloadPacket)) break;
+                    ChunkUnloadPacket *unload = (ChunkUnloadPacket *)event.packet->data;
+                    LOG_DEBUG("Unloading tile chunk at (%d, %d)", unload->chunk_x, unload->chunk_y);
+                    tilemap_unload_chunk(unload->chunk_x, unload->chunk_y);
+                    break;
+                }
+                case PKT_SNAPSHOT:
+                {
+                    handle_snapshot(event.packet->data, event.packet->dataLength);
                     break;
                 }
                 
                 //TODO: add pkt remove player / entity
                 default:
-                    printf("Unknown packet type: %d\n", packet_type);
-                    enet_packet_destroy(event.packet);
+                    LOG_WARN("Unknown packet type: %d", packet_type);
                     break;
                 }
+                // Handlers copy what they keep, so every packet is freed here
+                enet_packet_destroy(event.packet);
                 break;
             case ENET_EVENT_TYPE_DISCONNECT:
-                printf("Disconnected from server\n");
+                LOG_INFO("Disconnected from server");
                 connected = false;
                 connection_confirmed = false;
                 break;
+            default:
+                break;
         }
     }
 }
 
-void send_move(int dx, int dy)
+// Commands per second the server consumes, INPUT_RATE until the welcome arrives
+int get_server_tick_rate(void)
 {
-    MovePacket pkt = {PKT_MOVE, dx, dy};
-    ENetPacket *epkt = enet_packet_create(&pkt, sizeof(pkt), ENET_PACKET_FLAG_RELIABLE);
-    enet_peer_send(peer, 0, epkt);
+    return server_tick_rate;
+}
+
+// Record this frame's input and send it along with the previous few commands.
+// Nothing is sent once every command in the window is idle.
+bool send_input(int dx, int dy, InputCommand *sent)
+{
+    *sent = input_window_push(&recent_inputs, dx, dy);
+    if (input_window_is_idle(&recent_inputs))
+    {
+        return true;
+    }
+
+    uint8_t *buffer = packet_pool_acquire(INPUT_PACKET_MAX_SIZE);
+    if (!buffer)
+    {
+        return false;
+    }
+    WireWriter w;
+    wire_writer_init(&w, buffer, INPUT_PACKET_MAX_SIZE);
+    input_write_packet(&w, recent_inputs.commands, recent_inputs.count);
+    ENetPacket *epkt = packet_pool_wrap(buffer, w.size, 0);
+    if (!epkt)
+    {
+        return false;
+    }
+    if (enet_peer_send(peer, CHANNEL_STATE, epkt) != 0)
+    {
+        enet_packet_destroy(epkt);
+        return false;
+    }
+    return true;
 }
 
 void disconnect()
 {
     enet_peer_disconnect(peer, 0);
     enet_host_destroy(client);
+    packet_pool_shutdown();
     enet_deinitialize();
 }
 
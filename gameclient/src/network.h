@@ -2,6 +2,8 @@
 #define NETWORK_H
 
 #include "game.h"
+#include "../../common/src/input.h"
+#include "../../common/src/snapshot.h"
 
 #include <stdbool.h>
 
@@ -18,28 +20,28 @@
 
 // Packet types
 #define PKT_TILE_CHUNK 0x01
-#define PKT_MOVE 0x02
-#define PKT_PLAYER_POSITIONS 0x03
 #define PKT_PLAYER_ID 0x04
 #define PKT_ADD_PLAYER 0x05
 #define PKT_REMOVE_PLAYER 0x06
 // Define chunk size
-#define CHUNK_SIZE 5
-#define CHUNK_WIDTH 5
-#define CHUNK_HEIGHT 5
+#define CHUNK_WIDTH CHUNK_SIZE
+#define CHUNK_HEIGHT CHUNK_SIZE
 
 // Function declarations
 bool init_network(void);
 bool connect_to_server(const char *host, int port);
-void send_move(int dx, int dy);
+bool send_input(int dx, int dy, InputCommand *sent);
+int get_server_tick_rate(void);
 void handle_network(void);
+void handle_snapshot(const uint8_t *data, size_t length);
 void disconnect(void);
 bool is_connected(void);
-void update_player_positions(PlayerMap *map, const PlayerPositionsPacket *pkt);
-void set_local_player_id(PlayerMap *map, unsigned char player_id, unsigned char color_index);
+void apply_snapshot(PlayerMap *map, const Snapshot *snapshot);
+void reconcile_local_player(const Snapshot *snapshot, uint32_t input_ack);
+void set_local_player_id(PlayerMap *map, int player_id, unsigned char color_index);
 int get_local_player_id();
-void add_remote_player_id(PlayerMap *map, unsigned char player_id, unsigned char color_index);
-void remove_remote_player_id(PlayerMap *map, unsigned char player_id);
+void add_remote_player_id(PlayerMap *map, int player_id, unsigned char color_index);
+void remove_remote_player_id(PlayerMap *map, int player_id);
 // Global variables
 extern bool connected;
 extern bool connection_confirmed;
@@ -0,0 +1,73 @@
+#include <string.h>
+
+#include "prediction.h"
+#include "tilemap.h"
+#include "../../common/src/log.h"
+
+// Run one input with the same rules as the server's process_move(). Tiles in
+// chunks we have not received yet count as blocked.
+static void step(int *x, int *y, const InputCommand *input) {
+  int new_x = *x + input->dir_x;
+  int new_y = *y + input->dir_y;
+  const Tile *tile = tilemap_get_tile(new_x, new_y);
+  if (tile && tile->walkable) {
+    *x = new_x;
+    *y = new_y;
+  }
+}
+
+void prediction_reset(Prediction *prediction) {
+  memset(prediction, 0, sizeof(*prediction));
+}
+
+// Apply an input locally right away and remember it until the server confirms it
+void prediction_apply(Prediction *prediction, const InputCommand *input) {
+  if (prediction->pending_count == PREDICTION_HISTORY) {
+    // The server is not answering; the oldest input can no longer be replayed
+    memmove(prediction->pending, prediction->pending + 1,
+            (PREDICTION_HISTORY - 1) * sizeof(PredictedMove));
+    prediction->pending_count--;
+  }
+  if (prediction->has_state && !input_is_idle(input)) {
+    step(&prediction->x, &prediction->y, input);
+  }
+  PredictedMove *move = &prediction->pending[prediction->pending_count++];
+  move->input = *input;
+  move->x = prediction->x;
+  move->y = prediction->y;
+}
+
+// Rewind to the authoritative position the server reached after acked_sequence
+// and replay the inputs it has not processed yet
+void prediction_reconcile(Prediction *prediction, uint32_t acked_sequence, int server_x, int server_y) {
+  int confirmed = 0;
+  while (confirmed < prediction->pending_count &&
+         prediction->pending[confirmed].input.sequence <= acked_sequence) {
+    confirmed++;
+  }
+
+  // Compare with what we predicted for the same input
+  if (confirmed > 0) {
+    const PredictedMove *last = &prediction->pending[confirmed - 1];
+    if (last->input.sequence == acked_sequence && (last->x != server_x || last->y != server_y)) {
+      prediction->mispredictions++;
+      LOG_DEBUG("Misprediction at input %u: predicted (%d, %d), server (%d, %d)",
+                acked_sequence, last->x, last->y, server_x, server_y);
+    }
+  }
+  prediction->pending_count -= confirmed;
+  memmove(prediction->pending, prediction->pending + confirmed,
+          prediction->pending_count * sizeof(PredictedMove));
+
+  prediction->x = server_x;
+  prediction->y = server_y;
+  prediction->has_state = true;
+  for (int i = 0; i < prediction->pending_count; i++) {
+    PredictedMove *move = &prediction->pending[i];
+    if (!input_is_idle(&move->input)) {
+      step(&prediction->x, &prediction->y, &move->input);
+    }
+    move->x = prediction->x;
+    move->y = prediction->y;
+  }
+}
@@ -0,0 +1,33 @@
+#ifndef PREDICTION_H
+#define PREDICTION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../../common/src/input.h"
+
+// Inputs kept while waiting for the server to process them; at 20 Hz
+// this covers a few seconds of round trip
+#define PREDICTION_HISTORY 64
+
+// An input the server has not confirmed yet and where it left the player
+typedef struct {
+  InputCommand input;
+  int x;
+  int y;
+} PredictedMove;
+
+// Local player state run ahead of the server by the unconfirmed inputs
+typedef struct {
+  PredictedMove pending[PREDICTION_HISTORY]; // Oldest first
+  int pending_count;
+  int x; // Predicted position after every pending input
+  int y;
+  bool has_state;          // Set once the server has sent a position
+  uint32_t mispredictions; // Reconciliations that moved the player
+} Prediction;
+
+void prediction_reset(Prediction *prediction);
+void prediction_apply(Prediction *prediction, const InputCommand *input);
+void prediction_reconcile(Prediction *prediction, uint32_t acked_sequence, int server_x, int server_y);
+
+#endif // PREDICTION_H
@@ -0,0 +1,147 @@
+#include "tile_renderer.h"
+#include "tilemap.h"
+#include "../../common/src/log.h"
+
+#define CHUNK_PIXELS (CHUNK_SIZE * TILE_SIZE)
+
+static ChunkTexture textures[TILE_TEXTURE_POOL];
+static uint64_t frame = 0;
+
+static Color tile_color(unsigned char tile_id) {
+  switch (tile_id) {
+  case 0: // Empty/void
+    return BLACK;
+  case 1: // Grass
+    return DARKGREEN;
+  case 2: // Water
+    return BLUE;
+  case 3: // Sand
+    return YELLOW;
+  case 4: // Stone
+    return DARKGRAY;
+  default:
+    return PURPLE; // Unknown tile type
+  }
+}
+
+// Chunk range the camera can see
+static void visible_chunks(const Camera2D *camera, int *first_x, int *first_y, int *last_x,
+                           int *last_y) {
+  float left = camera->target.x - camera->offset.x;
+  float top = camera->target.y - camera->offset.y;
+  *first_x = (int)(left / CHUNK_PIXELS);
+  *first_y = (int)(top / CHUNK_PIXELS);
+  *last_x = (int)((left + GetScreenWidth()) / CHUNK_PIXELS);
+  *last_y = (int)((top + GetScreenHeight()) / CHUNK_PIXELS);
+  if (*first_x < 0) *first_x = 0;
+  if (*first_y < 0) *first_y = 0;
+}
+
+static ChunkTexture *find_texture(int chunk_x, int chunk_y) {
+  for (int i = 0; i < TILE_TEXTURE_POOL; i++) {
+    if (textures[i].assigned && textures[i].chunk_x == chunk_x && textures[i].chunk_y == chunk_y) {
+      return &textures[i];
+    }
+  }
+  return NULL;
+}
+
+// Hand the least recently drawn texture to a chunk
+static ChunkTexture *claim_texture(int chunk_x, int chunk_y) {
+  ChunkTexture *oldest = &textures[0];
+  for (int i = 0; i < TILE_TEXTURE_POOL; i++) {
+    if (!textures[i].assigned) {
+      oldest = &textures[i];
+      break;
+    }
+    if (textures[i].last_used < oldest->last_used) {
+      oldest = &textures[i];
+    }
+  }
+  if (oldest->assigned && oldest->last_used == frame) {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 1, "More chunks on screen than the %d cached textures",
+                     TILE_TEXTURE_POOL);
+  }
+  if (!oldest->allocated) {
+    oldest->target = LoadRenderTexture(CHUNK_PIXELS, CHUNK_PIXELS);
+    oldest->allocated = true;
+  }
+  oldest->assigned = true;
+  oldest->chunk_x = chunk_x;
+  oldest->chunk_y = chunk_y;
+  oldest->revision = 0; // Revisions start at 1, so this forces a render
+  return oldest;
+}
+
+static void render_chunk(ChunkTexture *texture, const ClientChunk *chunk) {
+  BeginTextureMode(texture->target);
+  ClearBackground(BLANK);
+  for (int y = 0; y < CHUNK_SIZE; y++) {
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+      const Tile *tile = &chunk->tiles[y * CHUNK_SIZE + x];
+      DrawRectangle(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE, tile_color(tile->tile_id));
+      DrawRectangleLines(x * TILE_SIZE, y * TILE_SIZE, TILE_SIZE, TILE_SIZE,
+                         (Color){50, 50, 50, 100});
+    }
+  }
+  EndTextureMode();
+  texture->revision = chunk->revision;
+  LOG_TRACE("Rendered chunk (%d, %d) revision %u", chunk->chunk_x, chunk->chunk_y,
+            chunk->revision);
+}
+
+// Re-render visible chunks that changed since they were last rendered.
+// Must run outside BeginMode2D, since texture mode resets the camera.
+void tile_renderer_update(const Camera2D *camera) {
+  int first_x, first_y, last_x, last_y;
+  visible_chunks(camera, &first_x, &first_y, &last_x, &last_y);
+  frame++;
+
+  for (int cy = first_y; cy <= last_y; cy++) {
+    for (int cx = first_x; cx <= last_x; cx++) {
+      const ClientChunk *chunk = tilemap_get_chunk(cx, cy);
+      if (!chunk) {
+        continue; // Not streamed in yet, leave the background
+      }
+      ChunkTexture *texture = find_texture(cx, cy);
+      if (!texture) {
+        texture = claim_texture(cx, cy);
+      }
+      if (texture->revision != chunk->revision) {
+        render_chunk(texture, chunk);
+      }
+      texture->last_used = frame;
+    }
+  }
+}
+
+// Blit the visible chunks; call inside BeginMode2D after tile_renderer_update()
+void tile_renderer_draw(const Camera2D *camera) {
+  int first_x, first_y, last_x, last_y;
+  visible_chunks(camera, &first_x, &first_y, &last_x, &last_y);
+
+  // Render textures are stored upside down
+  Rectangle source = {0, 0, CHUNK_PIXELS, -CHUNK_PIXELS};
+  for (int cy = first_y; cy <= last_y; cy++) {
+    for (int cx = first_x; cx <= last_x; cx++) {
+      const ClientChunk *chunk = tilemap_get_chunk(cx, cy);
+      const ChunkTexture *texture = find_texture(cx, cy);
+      if (!chunk || !texture || texture->revision != chunk->revision) {
+        continue;
+      }
+      Vector2 position = {(float)(cx * CHUNK_PIXELS), (float)(cy * CHUNK_PIXELS)};
+      DrawTextureRec(texture->target.texture, source, position, WHITE);
+    }
+  }
+}
+
+// Release the textures; call before closing the window
+void tile_renderer_unload(void) {
+  for (int i = 0; i < TILE_TEXTURE_POOL; i++) {
+    if (textures[i].allocated) {
+      UnloadRenderTexture(textures[i].target);
+    }
+    textures[i].allocated = false;
+    textures[i].assigned = false;
+  }
+}
@@ -0,0 +1,27 @@
+#ifndef TILE_RENDERER_H
+#define TILE_RENDERER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "raylib.h"
+#include "../../common/src/common.h"
+
+// Chunk textures kept at once; must cover the chunks visible on screen
+#define TILE_TEXTURE_POOL 16
+
+// Tile layer of one chunk, rendered once and blitted every frame
+typedef struct {
+  RenderTexture2D target;
+  bool allocated;
+  bool assigned;      // Holds a chunk
+  int chunk_x;
+  int chunk_y;
+  uint32_t revision;  // Chunk revision the texture was rendered from
+  uint64_t last_used; // Frame the texture was last drawn in
+} ChunkTexture;
+
+void tile_renderer_update(const Camera2D *camera);
+void tile_renderer_draw(const Camera2D *camera);
+void tile_renderer_unload(void);
+
+#endif // TILE_RENDERER_H
@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "tilemap.h"
+#include "../../common/src/log.h"
+#include "../../common/src/tiles.h"
+
+// Loaded chunks live in a toroidal cache indexed by chunk coordinates modulo
+// its size. The server only keeps chunks near the player loaded, so two
+// loaded chunks never share a slot.
+static ClientChunk chunk_cache[CHUNK_CACHE_SIZE][CHUNK_CACHE_SIZE];
+// Source of chunk revisions; keeps counting across clears so a cached
+// rendering of an older chunk never looks current
+static uint32_t next_revision = 1;
+
+static ClientChunk *cache_slot(int chunk_x, int chunk_y) {
+  return &chunk_cache[chunk_y % CHUNK_CACHE_SIZE][chunk_x % CHUNK_CACHE_SIZE];
+}
+
+// Forget every loaded chunk
+void tilemap_clear(void) {
+  memset(chunk_cache, 0, sizeof(chunk_cache));
+}
+
+// Store a chunk received from the server, deriving tile properties locally
+void tilemap_store_chunk(int chunk_x, int chunk_y, uint32_t version, const unsigned char *tile_ids) {
+  if (chunk_x < 0 || chunk_y < 0) {
+    return;
+  }
+  ClientChunk *chunk = cache_slot(chunk_x, chunk_y);
+  if (chunk->loaded && (chunk->chunk_x != chunk_x || chunk->chunk_y != chunk_y)) {
+    LOG_DEBUG("Chunk (%d, %d) replaces (%d, %d) in the cache", chunk_x, chunk_y,
+              chunk->chunk_x, chunk->chunk_y);
+  }
+  chunk->loaded = true;
+  chunk->chunk_x = chunk_x;
+  chunk->chunk_y = chunk_y;
+  chunk->revision = next_revision++;
+  chunk->version = version;
+  for (int i = 0; i < CHUNK_SIZE * CHUNK_SIZE; i++) {
+    chunk->tiles[i] = tile_from_id(tile_ids[i]);
+  }
+}
+
+// Apply a tile delta to a loaded chunk. A delta the chunk already includes is
+// ignored. Returns false if the chunk is missing or a delta in between was
+// missed, in which case the whole chunk has to be requested again.
+bool tilemap_apply_delta(int chunk_x, int chunk_y, uint32_t version, const TileChange *changes,
+                         int count) {
+  ClientChunk *chunk = (ClientChunk *)tilemap_get_chunk(chunk_x, chunk_y);
+  if (!chunk) {
+    return false;
+  }
+  if (version <= chunk->version) {
+    return true;
+  }
+  if (version != chunk->version + 1) {
+    LOG_DEBUG("Chunk (%d, %d) is at version %u, delta is for %u", chunk_x, chunk_y,
+              chunk->version, version);
+    return false;
+  }
+  for (int i = 0; i < count; i++) {
+    chunk->tiles[changes[i].index] = tile_from_id(changes[i].tile_id);
+  }
+  chunk->version = version;
+  chunk->revision = next_revision++;
+  return true;
+}
+
+// Drop a chunk the server told us we no longer need
+void tilemap_unload_chunk(int chunk_x, int chunk_y) {
+  ClientChunk *chunk = (ClientChunk *)tilemap_get_chunk(chunk_x, chunk_y);
+  if (chunk) {
+    chunk->loaded = false;
+  }
+}
+
+// Loaded chunk at the given chunk coordinates, NULL if we do not have it
+const ClientChunk *tilemap_get_chunk(int chunk_x, int chunk_y) {
+  if (chunk_x < 0 || chunk_y < 0) {
+    return NULL;
+  }
+  ClientChunk *chunk = cache_slot(chunk_x, chunk_y);
+  if (!chunk->loaded || chunk->chunk_x != chunk_x || chunk->chunk_y != chunk_y) {
+    return NULL;
+  }
+  return chunk;
+}
+
+// Tile at a world position, NULL if its chunk is not loaded
+const Tile *tilemap_get_tile(int x, int y) {
+  if (x < 0 || y < 0) {
+    return NULL;
+  }
+  const ClientChunk *chunk = tilemap_get_chunk(x / CHUNK_SIZE, y / CHUNK_SIZE);
+  if (!chunk) {
+    return NULL;
+  }
+  return &chunk->tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE];
+}
@@ -0,0 +1,28 @@
+#ifndef TILEMAP_H
+#define TILEMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../../common/src/chunk_codec.h"
+#include "../../common/src/common.h"
+
+// A chunk streamed from the server
+typedef struct {
+  bool loaded;
+  int chunk_x;
+  int chunk_y;
+  uint32_t revision; // Changes whenever the tiles change; never reused
+  uint32_t version;  // Server's version of the chunk, see PKT_TILE_DELTA
+  Tile tiles[CHUNK_SIZE * CHUNK_SIZE];
+} ClientChunk;
+
+// Tile map management functions
+void tilemap_clear(void);
+void tilemap_store_chunk(int chunk_x, int chunk_y, uint32_t version, const unsigned char *tile_ids);
+bool tilemap_apply_delta(int chunk_x, int chunk_y, uint32_t version, const TileChange *changes,
+                         int count);
+void tilemap_unload_chunk(int chunk_x, int chunk_y);
+const ClientChunk *tilemap_get_chunk(int chunk_x, int chunk_y);
+const Tile *tilemap_get_tile(int x, int y);
+
+#endif // TILEMAP_H
@@ -0,0 +1,90 @@
+#include "chunk_stream.h"
+#include "server.h"
+#include <stdlib.h>
+
+void chunk_stream_reset(ChunkStream *stream)
+{
+  stream->count = 0;
+  stream->center_x = -1;
+  stream->center_y = -1;
+  stream->complete = false;
+}
+
+bool chunk_stream_has(const ChunkStream *stream, int chunk_x, int chunk_y)
+{
+  for (int i = 0; i < stream->count; i++)
+  {
+    if (stream->chunks[i].x == chunk_x && stream->chunks[i].y == chunk_y)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Chebyshev distance between two chunks
+static int chunk_distance(int ax, int ay, int bx, int by)
+{
+  int dx = abs(ax - bx);
+  int dy = abs(ay - by);
+  return dx > dy ? dx : dy;
+}
+
+// Unload chunks that fell behind the player and send the ones coming into range,
+// nearest first
+void chunk_stream_update(ChunkStream *stream, const World *world, ENetPeer *peer,
+                         int tile_x, int tile_y)
+{
+  int center_x = tile_x / CHUNK_SIZE;
+  int center_y = tile_y / CHUNK_SIZE;
+
+  if (stream->complete && center_x == stream->center_x && center_y == stream->center_y)
+  {
+    return;
+  }
+  stream->center_x = center_x;
+  stream->center_y = center_y;
+
+  // Unload first so the client's cache slots are free for the new chunks.
+  // The extra chunk of slack stops a player on a border from thrashing.
+  for (int i = 0; i < stream->count;)
+  {
+    ChunkCoord *chunk = &stream->chunks[i];
+    if (chunk_distance(chunk->x, chunk->y, center_x, center_y) > CHUNK_STREAM_RADIUS + 1)
+    {
+      send_chunk_unload(peer, chunk->x, chunk->y);
+      *chunk = stream->chunks[--stream->count];
+    }
+    else
+    {
+      i++;
+    }
+  }
+
+  int sent = 0;
+  stream->complete = true;
+  for (int ring = 0; ring <= CHUNK_STREAM_RADIUS; ring++)
+  {
+    for (int y = center_y - ring; y <= center_y + ring; y++)
+    {
+      for (int x = center_x - ring; x <= center_x + ring; x++)
+      {
+        if (chunk_distance(x, y, center_x, center_y) != ring ||
+            !world_chunk_in_bounds(world, x, y) || chunk_stream_has(stream, x, y))
+        {
+          continue;
+        }
+        if (sent == MAX_CHUNK_SENDS_PER_TICK || stream->count == MAX_STREAMED_CHUNKS)
+        {
+          stream->complete = false;
+          return;
+        }
+        send_tile_chunk(peer, x, y);
+        stream->chunks[stream->count].x = x;
+        stream->chunks[stream->count].y = y;
+        stream->count++;
+        sent++;
+      }
+    }
+  }
+}
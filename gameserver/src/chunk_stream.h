@@ -0,0 +1,32 @@
+#ifndef CHUNK_STREAM_H
+#define CHUNK_STREAM_H
+
+#include <enet/enet.h>
+#include <stdbool.h>
+#include "world.h"
+
+// Most chunks a client can have loaded: everything up to one chunk past the radius
+#define MAX_STREAMED_CHUNKS ((2 * CHUNK_STREAM_RADIUS + 3) * (2 * CHUNK_STREAM_RADIUS + 3))
+// Spread the initial burst of chunks over several ticks
+#define MAX_CHUNK_SENDS_PER_TICK 16
+
+typedef struct {
+  int x;
+  int y;
+} ChunkCoord;
+
+// The set of chunks a client currently has loaded
+typedef struct {
+  int count;
+  ChunkCoord chunks[MAX_STREAMED_CHUNKS];
+  int center_x;   // Chunk the player was in at the last update
+  int center_y;
+  bool complete;  // Every chunk within the radius has been sent
+} ChunkStream;
+
+void chunk_stream_reset(ChunkStream *stream);
+bool chunk_stream_has(const ChunkStream *stream, int chunk_x, int chunk_y);
+void chunk_stream_update(ChunkStream *stream, const World *world, ENetPeer *peer,
+                         int tile_x, int tile_y);
+
+#endif // CHUNK_STREAM_H
@@ -0,0 +1,189 @@
+#include "enemies.h"
+#include "flow_field.h"
+#include "walk_query.h"
+#include "world.h"
+#include "../../common/src/log.h"
+#include <stdlib.h>
+
+// Most players considered when an enemy looks for a target
+#define ENEMY_MAX_CANDIDATES 64
+
+// extern global world, defined in server.c
+extern World world;
+
+// Server-side entities; each type has its own pool
+EntityWorld entities;
+// Flow fields shared by every enemy chasing players in the same region
+static FlowCache flow_cache;
+static int enemy_sight_radius;
+
+// Spawn enemies on random walkable tiles
+bool enemies_init(int count, int sight_radius)
+{
+  enemy_sight_radius = sight_radius;
+  if (!entity_world_init(&entities, ENTITY_TYPE_COUNT, count) || !flow_cache_init(&flow_cache))
+  {
+    LOG_ERROR("Failed to allocate storage for %d enemies", count);
+    return false;
+  }
+
+  int spawned = 0;
+  for (int attempt = 0; attempt < count * 16 && spawned < count; attempt++)
+  {
+    int x = rand() % world.width;
+    int y = rand() % world.height;
+    if (!world_is_walkable(&world, x, y))
+    {
+      continue;
+    }
+    EntityHandle handle = entity_spawn(&entities, ENTITY_ENEMY);
+    if (handle == ENTITY_HANDLE_NONE)
+    {
+      break;
+    }
+    EntityPool *pool = entity_pool(&entities, ENTITY_ENEMY);
+    int index = entity_index(&entities, handle);
+    pool->x[index] = x;
+    pool->y[index] = y;
+    // Spread the steps over the interval instead of moving everyone at once
+    pool->timer[index] = ENEMY_STEP_SECONDS * (float)rand() / RAND_MAX;
+    spawned++;
+  }
+  if (count > 0)
+  {
+    LOG_INFO("Spawned %d of %d enemies", spawned, count);
+  }
+  return true;
+}
+
+void enemies_shutdown(void)
+{
+  if (flow_cache.queue)
+  {
+    LOG_INFO("Flow fields: %llu built, %llu reused, %llu repaired",
+             (unsigned long long)flow_cache.builds, (unsigned long long)flow_cache.hits,
+             (unsigned long long)flow_cache.repairs);
+  }
+  flow_cache_free(&flow_cache);
+  entity_world_destroy(&entities);
+}
+
+// Player an enemy goes after: the one it is already chasing while that
+// player stays in range, otherwise the closest one it has a clear line of
+// sight to. -1 if there is none.
+static int find_target(const SpatialGrid *grid, int x, int y, int current)
+{
+  int candidates[ENEMY_MAX_CANDIDATES];
+  int count = spatial_grid_query_radius(grid, x, y, enemy_sight_radius, candidates,
+                                        ENEMY_MAX_CANDIDATES);
+  int best = -1;
+  int best_distance = 0;
+  for (int i = 0; i < count; i++)
+  {
+    if (candidates[i] == current)
+    {
+      return current;
+    }
+  }
+  for (int i = 0; i < count; i++)
+  {
+    int target_x = grid->pos_x[candidates[i]];
+    int target_y = grid->pos_y[candidates[i]];
+    int distance = (target_x - x) * (target_x - x) + (target_y - y) * (target_y - y);
+    // Ties go to the lower id so the choice does not depend on grid order
+    if ((best < 0 || distance < best_distance ||
+         (distance == best_distance && candidates[i] < best)) &&
+        walk_line_of_sight(&world, x, y, target_x, target_y))
+    {
+      best = candidates[i];
+      best_distance = distance;
+    }
+  }
+  return best;
+}
+
+static int sign(int value)
+{
+  return (value > 0) - (value < 0);
+}
+
+// Pick the step an enemy takes toward a player. Far away it follows the flow
+// field of the player's region; inside that region it heads straight for the
+// player.
+static bool choose_step(int x, int y, const Player *target, int *dx, int *dy)
+{
+  const FlowField *field = flow_cache_get(&flow_cache, &world, target->x / FLOW_REGION_SIZE,
+                                          target->y / FLOW_REGION_SIZE);
+  if (field && flow_field_step(field, x, y, dx, dy))
+  {
+    return true;
+  }
+
+  *dx = sign(target->x - x);
+  *dy = sign(target->y - y);
+  if (*dx == 0 && *dy == 0)
+  {
+    return false;
+  }
+  if (*dx != 0 && *dy != 0 && !world_is_walkable(&world, x + *dx, y + *dy))
+  {
+    // Slide along whichever axis is open
+    if (world_is_walkable(&world, x + *dx, y))
+    {
+      *dy = 0;
+    }
+    else
+    {
+      *dx = 0;
+    }
+  }
+  return world_is_walkable(&world, x + *dx, y + *dy);
+}
+
+// Step every enemy whose timer ran out toward the nearest player it can see
+void enemies_update(ServerPlayerMap *map, PlayerGridLookup grid_at, float dt)
+{
+  EntityPool *pool = entity_pool(&entities, ENTITY_ENEMY);
+  if (!pool)
+  {
+    return;
+  }
+  for (int i = 0; i < pool->count; i++)
+  {
+    pool->timer[i] -= dt;
+    if (pool->timer[i] > 0)
+    {
+      continue;
+    }
+    pool->timer[i] += ENEMY_STEP_SECONDS;
+
+    int x = (int)pool->x[i];
+    int y = (int)pool->y[i];
+    // owner holds the chased player's id plus one, 0 for none
+    int target = find_target(grid_at(x), x, y, (int)pool->owner[i] - 1);
+    pool->owner[i] = target + 1;
+    if (target < 0)
+    {
+      continue;
+    }
+
+    int dx, dy;
+    if (choose_step(x, y, &map->entries[target].player, &dx, &dy))
+    {
+      pool->x[i] = x + dx;
+      pool->y[i] = y + dy;
+    }
+  }
+}
+
+// Keep cached paths in step with a tile whose walkability may have changed
+void enemies_tile_changed(int x, int y)
+{
+  flow_cache_tile_changed(&flow_cache, &world, x, y);
+}
+
+// Drop every cached path, e.g. after the whole map was replaced
+void enemies_reset_paths(void)
+{
+  flow_cache_clear(&flow_cache);
+}
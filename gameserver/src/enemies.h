@@ -0,0 +1,21 @@
+#ifndef ENEMIES_H
+#define ENEMIES_H
+
+#include <stdbool.h>
+#include "player_map.h"
+#include "spatial_grid.h"
+#include "../../criogenio/src/entities.h"
+
+// Seconds between two steps of an enemy
+#define ENEMY_STEP_SECONDS 0.25f
+
+// Grid to look up players near a tile column; zones each have their own
+typedef const SpatialGrid *(*PlayerGridLookup)(int x);
+
+bool enemies_init(int count, int sight_radius);
+void enemies_shutdown(void);
+void enemies_update(ServerPlayerMap *map, PlayerGridLookup grid_at, float dt);
+void enemies_tile_changed(int x, int y);
+void enemies_reset_paths(void);
+
+#endif // ENEMIES_H
@@ -0,0 +1,354 @@
+#include "flow_field.h"
+#include "../../common/src/log.h"
+#include <stdlib.h>
+
+#define FLOW_WINDOW_AREA (FLOW_FIELD_SPAN * FLOW_FIELD_SPAN)
+
+static const int neighbor_dx[4] = {1, -1, 0, 0};
+static const int neighbor_dy[4] = {0, 0, 1, -1};
+
+bool flow_cache_init(FlowCache *cache)
+{
+  *cache = (FlowCache){0};
+  cache->queue = malloc(FLOW_WINDOW_AREA * sizeof(FlowNode));
+  cache->seeds = malloc(FLOW_WINDOW_AREA * sizeof(FlowNode));
+  cache->invalidated = malloc(FLOW_WINDOW_AREA * sizeof(FlowNode));
+  bool ok = cache->queue && cache->seeds && cache->invalidated;
+  for (int i = 0; i < FLOW_CACHE_SIZE && ok; i++)
+  {
+    cache->fields[i].dist = malloc(FLOW_WINDOW_AREA * sizeof(uint16_t));
+    ok = cache->fields[i].dist != NULL;
+  }
+  if (!ok)
+  {
+    LOG_ERROR("Failed to allocate flow field cache");
+    flow_cache_free(cache);
+    return false;
+  }
+  return true;
+}
+
+void flow_cache_free(FlowCache *cache)
+{
+  for (int i = 0; i < FLOW_CACHE_SIZE; i++)
+  {
+    free(cache->fields[i].dist);
+    cache->fields[i].dist = NULL;
+    cache->fields[i].valid = false;
+  }
+  free(cache->queue);
+  free(cache->seeds);
+  free(cache->invalidated);
+  cache->queue = cache->seeds = cache->invalidated = NULL;
+}
+
+// Forget every field, e.g. after the whole map changed
+void flow_cache_clear(FlowCache *cache)
+{
+  for (int i = 0; i < FLOW_CACHE_SIZE; i++)
+  {
+    cache->fields[i].valid = false;
+  }
+}
+
+static bool in_region(const FlowField *field, int world_x, int world_y)
+{
+  return world_x / FLOW_REGION_SIZE == field->region_x &&
+         world_y / FLOW_REGION_SIZE == field->region_y;
+}
+
+static bool window_walkable(const FlowField *field, const World *world, int index)
+{
+  return world_is_walkable(world, field->origin_x + index % field->width,
+                           field->origin_y + index / field->width);
+}
+
+// Breadth-first search from a list of seeds sorted by distance. Seeds and
+// queued tiles are merged in distance order, so every tile is settled at
+// its final distance the first time it is reached and each tile is queued
+// at most once. Entries whose tile has since been lowered are skipped.
+static void propagate(FlowCache *cache, FlowField *field, const World *world, int seed_count)
+{
+  int head = 0;
+  int tail = 0;
+  int next_seed = 0;
+  while (next_seed < seed_count || head < tail)
+  {
+    FlowNode node;
+    if (head == tail ||
+        (next_seed < seed_count && cache->seeds[next_seed].dist <= cache->queue[head].dist))
+    {
+      node = cache->seeds[next_seed++];
+    }
+    else
+    {
+      node = cache->queue[head++];
+    }
+    if (field->dist[node.index] != node.dist)
+    {
+      continue;
+    }
+
+    int x = node.index % field->width;
+    int y = node.index / field->width;
+    uint16_t next = node.dist + 1;
+    for (int i = 0; i < 4; i++)
+    {
+      int nx = x + neighbor_dx[i];
+      int ny = y + neighbor_dy[i];
+      if (nx < 0 || ny < 0 || nx >= field->width || ny >= field->height)
+      {
+        continue;
+      }
+      int neighbor = ny * field->width + nx;
+      if (field->dist[neighbor] <= next || !window_walkable(field, world, neighbor))
+      {
+        continue;
+      }
+      field->dist[neighbor] = next;
+      cache->queue[tail++] = (FlowNode){neighbor, next};
+    }
+  }
+}
+
+static void build_field(FlowCache *cache, FlowField *field, const World *world, int region_x,
+                        int region_y)
+{
+  field->region_x = region_x;
+  field->region_y = region_y;
+  field->origin_x = region_x * FLOW_REGION_SIZE - FLOW_FIELD_RADIUS;
+  field->origin_y = region_y * FLOW_REGION_SIZE - FLOW_FIELD_RADIUS;
+  int end_x = field->origin_x + FLOW_FIELD_SPAN;
+  int end_y = field->origin_y + FLOW_FIELD_SPAN;
+  if (field->origin_x < 0) field->origin_x = 0;
+  if (field->origin_y < 0) field->origin_y = 0;
+  if (end_x > world->width) end_x = world->width;
+  if (end_y > world->height) end_y = world->height;
+  field->width = end_x - field->origin_x;
+  field->height = end_y - field->origin_y;
+  field->valid = true;
+
+  int area = field->width * field->height;
+  for (int i = 0; i < area; i++)
+  {
+    field->dist[i] = FLOW_UNREACHABLE;
+  }
+
+  // Every walkable tile of the region is a goal
+  int seed_count = 0;
+  for (int y = region_y * FLOW_REGION_SIZE; y < (region_y + 1) * FLOW_REGION_SIZE; y++)
+  {
+    for (int x = region_x * FLOW_REGION_SIZE; x < (region_x + 1) * FLOW_REGION_SIZE; x++)
+    {
+      if (x >= end_x || y >= end_y || !world_is_walkable(world, x, y))
+      {
+        continue;
+      }
+      int index = (y - field->origin_y) * field->width + (x - field->origin_x);
+      field->dist[index] = 0;
+      cache->seeds[seed_count++] = (FlowNode){index, 0};
+    }
+  }
+  propagate(cache, field, world, seed_count);
+  cache->builds++;
+}
+
+// Field leading to a region, built on first use and kept until evicted.
+// NULL if the region lies outside the world.
+const FlowField *flow_cache_get(FlowCache *cache, const World *world, int region_x, int region_y)
+{
+  if (region_x < 0 || region_y < 0 || region_x * FLOW_REGION_SIZE >= world->width ||
+      region_y * FLOW_REGION_SIZE >= world->height)
+  {
+    return NULL;
+  }
+
+  cache->clock++;
+  FlowField *oldest = &cache->fields[0];
+  for (int i = 0; i < FLOW_CACHE_SIZE; i++)
+  {
+    FlowField *field = &cache->fields[i];
+    if (field->valid && field->region_x == region_x && field->region_y == region_y)
+    {
+      field->last_used = cache->clock;
+      cache->hits++;
+      return field;
+    }
+    if (!field->valid || (oldest->valid && field->last_used < oldest->last_used))
+    {
+      oldest = field;
+    }
+  }
+
+  build_field(cache, oldest, world, region_x, region_y);
+  oldest->last_used = cache->clock;
+  LOG_TRACE("Built flow field for region (%d, %d)", region_x, region_y);
+  return oldest;
+}
+
+static int compare_nodes(const void *a, const void *b)
+{
+  return (int)((const FlowNode *)a)->dist - (int)((const FlowNode *)b)->dist;
+}
+
+// Smallest distance among a tile's neighbors, FLOW_UNREACHABLE if none is reached
+static uint16_t lowest_neighbor(const FlowField *field, int index)
+{
+  int x = index % field->width;
+  int y = index / field->width;
+  uint16_t lowest = FLOW_UNREACHABLE;
+  for (int i = 0; i < 4; i++)
+  {
+    int nx = x + neighbor_dx[i];
+    int ny = y + neighbor_dy[i];
+    if (nx < 0 || ny < 0 || nx >= field->width || ny >= field->height)
+    {
+      continue;
+    }
+    uint16_t dist = field->dist[ny * field->width + nx];
+    if (dist < lowest)
+    {
+      lowest = dist;
+    }
+  }
+  return lowest;
+}
+
+// A tile became walkable: give it a distance from its neighbors and let the
+// improvement spread
+static void repair_opened(FlowCache *cache, FlowField *field, const World *world, int index)
+{
+  uint16_t dist;
+  if (in_region(field, field->origin_x + index % field->width,
+                field->origin_y + index / field->width))
+  {
+    dist = 0;
+  }
+  else
+  {
+    uint16_t lowest = lowest_neighbor(field, index);
+    if (lowest == FLOW_UNREACHABLE)
+    {
+      return;
+    }
+    dist = lowest + 1;
+  }
+  field->dist[index] = dist;
+  cache->seeds[0] = (FlowNode){index, dist};
+  propagate(cache, field, world, 1);
+}
+
+// A tile became a wall: clear every distance that was only reachable
+// through it, then search again from the edge of the cleared area.
+// Tiles are cleared in order of their old distance, so by the time a tile
+// is checked every tile one step closer to the goal has already been
+// cleared if it is going to be.
+static void repair_blocked(FlowCache *cache, FlowField *field, const World *world, int index)
+{
+  int count = 0;
+  cache->invalidated[count++] = (FlowNode){index, field->dist[index]};
+  field->dist[index] = FLOW_UNREACHABLE;
+
+  for (int k = 0; k < count; k++)
+  {
+    FlowNode cleared = cache->invalidated[k];
+    int x = cleared.index % field->width;
+    int y = cleared.index / field->width;
+    for (int i = 0; i < 4; i++)
+    {
+      int nx = x + neighbor_dx[i];
+      int ny = y + neighbor_dy[i];
+      if (nx < 0 || ny < 0 || nx >= field->width || ny >= field->height)
+      {
+        continue;
+      }
+      int neighbor = ny * field->width + nx;
+      uint16_t dist = field->dist[neighbor];
+      // Only tiles one step further away could have depended on this one,
+      // and only if no other neighbor still leads to the goal
+      if (dist != cleared.dist + 1 || lowest_neighbor(field, neighbor) == dist - 1)
+      {
+        continue;
+      }
+      field->dist[neighbor] = FLOW_UNREACHABLE;
+      cache->invalidated[count++] = (FlowNode){neighbor, dist};
+    }
+  }
+
+  int seed_count = 0;
+  for (int k = 1; k < count; k++)
+  {
+    int cleared = cache->invalidated[k].index;
+    uint16_t lowest = lowest_neighbor(field, cleared);
+    if (lowest != FLOW_UNREACHABLE && field->dist[cleared] > lowest + 1)
+    {
+      field->dist[cleared] = lowest + 1;
+      cache->seeds[seed_count++] = (FlowNode){cleared, lowest + 1};
+    }
+  }
+  qsort(cache->seeds, seed_count, sizeof(FlowNode), compare_nodes);
+  propagate(cache, field, world, seed_count);
+}
+
+// Bring every cached field covering a tile up to date after the tile's
+// walkability may have changed. Only the part of a field whose distances
+// actually depend on the tile is searched again.
+void flow_cache_tile_changed(FlowCache *cache, const World *world, int x, int y)
+{
+  bool walkable = world_is_walkable(world, x, y);
+  for (int i = 0; i < FLOW_CACHE_SIZE; i++)
+  {
+    FlowField *field = &cache->fields[i];
+    int lx = x - field->origin_x;
+    int ly = y - field->origin_y;
+    if (!field->valid || lx < 0 || ly < 0 || lx >= field->width || ly >= field->height)
+    {
+      continue;
+    }
+    int index = ly * field->width + lx;
+    bool reached = field->dist[index] != FLOW_UNREACHABLE;
+    if (walkable && !reached)
+    {
+      repair_opened(cache, field, world, index);
+      cache->repairs++;
+    }
+    else if (!walkable && reached)
+    {
+      repair_blocked(cache, field, world, index);
+      cache->repairs++;
+    }
+  }
+}
+
+// Direction one step down the field from a tile. False when the tile is
+// already in the target region, cut off from it, or outside the field.
+bool flow_field_step(const FlowField *field, int x, int y, int *dx, int *dy)
+{
+  int lx = x - field->origin_x;
+  int ly = y - field->origin_y;
+  if (lx < 0 || ly < 0 || lx >= field->width || ly >= field->height)
+  {
+    return false;
+  }
+  uint16_t dist = field->dist[ly * field->width + lx];
+  if (dist == 0 || dist == FLOW_UNREACHABLE)
+  {
+    return false;
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    int nx = lx + neighbor_dx[i];
+    int ny = ly + neighbor_dy[i];
+    if (nx < 0 || ny < 0 || nx >= field->width || ny >= field->height)
+    {
+      continue;
+    }
+    if (field->dist[ny * field->width + nx] == dist - 1)
+    {
+      *dx = neighbor_dx[i];
+      *dy = neighbor_dy[i];
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,59 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "world.h"
+
+// Players inside the same square region share one flow field
+#define FLOW_REGION_SIZE 8
+// How far around its target region a field is searched, in tiles
+#define FLOW_FIELD_RADIUS 48
+#define FLOW_FIELD_SPAN (2 * FLOW_FIELD_RADIUS + FLOW_REGION_SIZE)
+// Fields kept at once; the least recently used one is rebuilt for a new region
+#define FLOW_CACHE_SIZE 32
+#define FLOW_UNREACHABLE 0xFFFF
+
+// Distance in steps from every tile of a window to the nearest walkable
+// tile of the target region, filled by one breadth-first search from the
+// whole region. Any number of enemies heading for the region walk downhill
+// on the same field.
+typedef struct {
+  bool valid;
+  int region_x;
+  int region_y;
+  int origin_x;        // World tile of dist[0]
+  int origin_y;
+  int width;           // Window size, clipped to the world
+  int height;
+  uint64_t last_used;
+  uint16_t *dist;      // Row-major, FLOW_UNREACHABLE for walls and cut-off tiles
+} FlowField;
+
+// Search queue entry: window index and the distance it was queued with
+typedef struct {
+  int index;
+  uint16_t dist;
+} FlowNode;
+
+typedef struct {
+  FlowField fields[FLOW_CACHE_SIZE];
+  uint64_t clock;
+  // Scratch space for builds and repairs, one window each
+  FlowNode *queue;
+  FlowNode *seeds;
+  FlowNode *invalidated;
+  // Counters for the shutdown report
+  uint64_t builds;
+  uint64_t hits;
+  uint64_t repairs;
+} FlowCache;
+
+bool flow_cache_init(FlowCache *cache);
+void flow_cache_free(FlowCache *cache);
+void flow_cache_clear(FlowCache *cache);
+const FlowField *flow_cache_get(FlowCache *cache, const World *world, int region_x, int region_y);
+void flow_cache_tile_changed(FlowCache *cache, const World *world, int x, int y);
+bool flow_field_step(const FlowField *field, int x, int y, int *dx, int *dy);
+
+#endif // FLOW_FIELD_H
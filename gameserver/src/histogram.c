@@ -0,0 +1,81 @@
+#include "histogram.h"
+#include <string.h>
+
+// Bucket a value falls into
+static int histogram_bucket(uint32_t value)
+{
+  if (value < HISTOGRAM_SUB_BUCKETS)
+  {
+    return value;
+  }
+  // Keep the top HISTOGRAM_SUB_BITS bits; the highest one is always set
+  int exponent = 31 - __builtin_clz(value);
+  int shift = exponent - (HISTOGRAM_SUB_BITS - 1);
+  int sub = (value >> shift) - HISTOGRAM_HALF_BUCKETS;
+  return HISTOGRAM_SUB_BUCKETS + (shift - 1) * HISTOGRAM_HALF_BUCKETS + sub;
+}
+
+// Largest value that lands in a bucket
+static uint32_t histogram_bucket_limit(int bucket)
+{
+  if (bucket < HISTOGRAM_SUB_BUCKETS)
+  {
+    return bucket;
+  }
+  int shift = (bucket - HISTOGRAM_SUB_BUCKETS) / HISTOGRAM_HALF_BUCKETS + 1;
+  int sub = (bucket - HISTOGRAM_SUB_BUCKETS) % HISTOGRAM_HALF_BUCKETS + HISTOGRAM_HALF_BUCKETS;
+  return (uint32_t)((((uint64_t)sub + 1) << shift) - 1);
+}
+
+void histogram_reset(Histogram *h)
+{
+  memset(h, 0, sizeof(*h));
+  h->min = UINT32_MAX;
+}
+
+void histogram_record(Histogram *h, uint32_t value)
+{
+  h->counts[histogram_bucket(value)]++;
+  h->count++;
+  h->total += value;
+  if (value < h->min)
+  {
+    h->min = value;
+  }
+  if (value > h->max)
+  {
+    h->max = value;
+  }
+}
+
+// Smallest bucket limit that covers the given percentage of the values,
+// clamped to the largest value actually recorded
+uint32_t histogram_percentile(const Histogram *h, double percentile)
+{
+  if (h->count == 0)
+  {
+    return 0;
+  }
+  uint64_t target = (uint64_t)(h->count * percentile / 100.0 + 0.5);
+  if (target == 0)
+  {
+    target = 1;
+  }
+
+  uint64_t seen = 0;
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+  {
+    seen += h->counts[i];
+    if (seen >= target)
+    {
+      uint32_t limit = histogram_bucket_limit(i);
+      return limit < h->max ? limit : h->max;
+    }
+  }
+  return h->max;
+}
+
+double histogram_mean(const Histogram *h)
+{
+  return h->count ? (double)h->total / h->count : 0.0;
+}
@@ -0,0 +1,29 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+// Log-linear histogram in the style of HdrHistogram: values below
+// HISTOGRAM_SUB_BUCKETS get their own bucket, every power of two above that is
+// split into HISTOGRAM_SUB_BUCKETS / 2 buckets, so any recorded value is off by
+// at most 1/16 of itself. Recording is O(1) and never allocates.
+#define HISTOGRAM_SUB_BITS 5
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_HALF_BUCKETS (HISTOGRAM_SUB_BUCKETS / 2)
+#define HISTOGRAM_BUCKETS \
+  (HISTOGRAM_SUB_BUCKETS + (32 - HISTOGRAM_SUB_BITS) * HISTOGRAM_HALF_BUCKETS)
+
+typedef struct {
+  uint32_t counts[HISTOGRAM_BUCKETS];
+  uint64_t count; // Values recorded
+  uint64_t total; // Sum of the recorded values
+  uint32_t min;
+  uint32_t max;
+} Histogram;
+
+void histogram_reset(Histogram *h);
+void histogram_record(Histogram *h, uint32_t value);
+uint32_t histogram_percentile(const Histogram *h, double percentile);
+double histogram_mean(const Histogram *h);
+
+#endif // HISTOGRAM_H
@@ -0,0 +1,64 @@
+#include "input_buffer.h"
+#include <string.h>
+
+void input_buffer_reset(InputBuffer *buffer)
+{
+  memset(buffer, 0, sizeof(*buffer));
+}
+
+// Queue the commands from one input packet. Commands already received or
+// already applied are repeats and are ignored. Returns the number queued.
+int input_buffer_push(InputBuffer *buffer, const InputCommand *commands, int count)
+{
+  int queued = 0;
+  for (int i = 0; i < count; i++)
+  {
+    uint32_t sequence = commands[i].sequence;
+    if (sequence <= buffer->last_applied)
+    {
+      continue;
+    }
+    InputCommand *slot = &buffer->commands[sequence % INPUT_BUFFER_SIZE];
+    if (slot->sequence == sequence)
+    {
+      continue;
+    }
+    *slot = commands[i];
+    queued++;
+    if (sequence > buffer->last_received)
+    {
+      buffer->last_received = sequence;
+    }
+  }
+
+  // Keep the queue short and make sure it never wraps onto itself
+  if (buffer->last_received - buffer->last_applied > INPUT_MAX_PENDING)
+  {
+    uint32_t skip_to = buffer->last_received - INPUT_MAX_PENDING;
+    buffer->dropped += skip_to - buffer->last_applied;
+    buffer->last_applied = skip_to;
+  }
+  return queued;
+}
+
+// Take the next movement command in sequence order. Idle commands, and
+// commands that never arrived, are consumed on the way: skipping them changes
+// when a player moves but not where. Returns false when nothing is left.
+bool input_buffer_pop(InputBuffer *buffer, InputCommand *command)
+{
+  while (buffer->last_applied < buffer->last_received)
+  {
+    uint32_t sequence = ++buffer->last_applied;
+    const InputCommand *slot = &buffer->commands[sequence % INPUT_BUFFER_SIZE];
+    if (slot->sequence != sequence)
+    {
+      buffer->dropped++;
+    }
+    else if (!input_is_idle(slot))
+    {
+      *command = *slot;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,27 @@
+#ifndef INPUT_BUFFER_H
+#define INPUT_BUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../../common/src/input.h"
+
+// Commands kept per client, indexed by sequence; must exceed INPUT_REDUNDANCY
+#define INPUT_BUFFER_SIZE 32
+// Queued commands beyond this are dropped, oldest first, so a client that
+// sends faster than the tick rate cannot build up input lag
+#define INPUT_MAX_PENDING 4
+
+// Commands received from one client and not yet applied
+typedef struct {
+  InputCommand commands[INPUT_BUFFER_SIZE];
+  uint32_t last_received; // Newest sequence stored
+  uint32_t last_applied;  // Newest sequence consumed by the simulation
+  uint32_t last_reported; // last_applied as of the last snapshot sent
+  uint32_t dropped;       // Commands skipped because they were lost or late
+} InputBuffer;
+
+void input_buffer_reset(InputBuffer *buffer);
+int input_buffer_push(InputBuffer *buffer, const InputCommand *commands, int count);
+bool input_buffer_pop(InputBuffer *buffer, InputCommand *command);
+
+#endif // INPUT_BUFFER_H
@@ -1,54 +1,395 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <signal.h>
+#include <time.h>
 #include "server.h"
+#include "tick.h"
+#include "profiler.h"
+#include "replay.h"
+#include "world.h"
+#include "zones.h"
+#include "../../criogenio/src/entities.h"
+#include "../../common/src/log.h"
 
 // Global variables
 ServerPlayerMap player_map = {0};
+ServerConfig server_config = {DEFAULT_TICK_RATE, DEFAULT_AOI_RADIUS, "map.txt",
+                              DEFAULT_PROFILE_FILE, DEFAULT_PROFILE_INTERVAL, false, 0,
+                              DEFAULT_MAX_PLAYERS, 0, NULL, NULL};
+TickScheduler scheduler;
+Profiler profiler;
+// extern global world, defined in server.c
+extern World world;
 
 // Global flag for graceful shutdown
 // This flag is set to 0 when a signal is received, indicating that the server should stop running.
-volatile int running = 1;
+volatile sig_atomic_t running = 1;
+// Set by SIGUSR1 to write a profiler report after the current tick
+volatile sig_atomic_t profile_dump_requested = 0;
+// Set by SIGHUP to load the map file again after the current tick
+volatile sig_atomic_t map_reload_requested = 0;
 
 // Signal handler for graceful shutdown
 void signal_handler(int signum)
 {
-    printf("\nReceived signal %d, shutting down...\n", signum);
-    cleanup_server();
-    exit(0);
+    // The main loop wakes up within one tick and cleans up
+    running = 0;
+}
+
+// Signal handler asking for a profiler report
+void profile_signal_handler(int signum)
+{
+    (void)signum;
+    profile_dump_requested = 1;
+}
+
+// Signal handler asking for the map file to be reloaded
+void map_reload_signal_handler(int signum)
+{
+    (void)signum;
+    map_reload_requested = 1;
 }
 
-int main(void)
+// Print command line usage
+void print_usage(const char *program)
 {
+    printf("Usage: %s [--tick-rate <hz>] [--aoi-radius <tiles>] [--map <file>] [--profile-file <file>] [--profile-interval <seconds>] [--net-thread] [--zones <count>] [--max-players <count>] [--enemies <count>] [--record <file>] [--replay <file>] [--log-level <trace|debug|info|warn|error|off>]\n", program);
+}
+
+// Parse command line arguments into the server config
+bool parse_args(int argc, char *argv[], ServerConfig *config)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+        {
+            int tick_rate = atoi(argv[++i]);
+            if (tick_rate <= 0 || tick_rate > MAX_TICK_RATE)
+            {
+                printf("Tick rate must be between 1 and %d\n", MAX_TICK_RATE);
+                return false;
+            }
+            config->tick_rate = tick_rate;
+        }
+        else if (strcmp(argv[i], "--aoi-radius") == 0 && i + 1 < argc)
+        {
+            config->aoi_radius = atoi(argv[++i]);
+            if (config->aoi_radius <= 0)
+            {
+                printf("Area of interest radius must be positive\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc)
+        {
+            config->map_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--profile-file") == 0 && i + 1 < argc)
+        {
+            config->profile_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--profile-interval") == 0 && i + 1 < argc)
+        {
+            config->profile_interval = atoi(argv[++i]);
+            if (config->profile_interval < 0)
+            {
+                printf("Profile interval must not be negative\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--net-thread") == 0)
+        {
+            config->net_thread = true;
+        }
+        else if (strcmp(argv[i], "--zones") == 0 && i + 1 < argc)
+        {
+            config->zones = atoi(argv[++i]);
+            if (config->zones < 0 || config->zones > MAX_ZONES)
+            {
+                printf("Zone count must be between 0 and %d\n", MAX_ZONES);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--max-players") == 0 && i + 1 < argc)
+        {
+            config->max_players = atoi(argv[++i]);
+            if (config->max_players <= 0 || config->max_players > MAX_PLAYER_LIMIT)
+            {
+                printf("Max players must be between 1 and %d\n", MAX_PLAYER_LIMIT);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--enemies") == 0 && i + 1 < argc)
+        {
+            config->enemies = atoi(argv[++i]);
+            if (config->enemies < 0 || config->enemies > ENTITY_MAX_PER_TYPE)
+            {
+                printf("Enemy count must be between 0 and %d\n", ENTITY_MAX_PER_TYPE);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+        {
+            config->record_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+        {
+            config->replay_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc)
+        {
+            int level = log_parse_level(argv[++i]);
+            if (level < 0)
+            {
+                printf("Unknown log level: %s\n", argv[i]);
+                return false;
+            }
+            log_set_level(level);
+        }
+        else
+        {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Run one fixed step and account for it
+static void run_tick(void)
+{
+    tick_begin(&scheduler);
+    server_tick(&player_map, scheduler.tick);
+    tick_end(&scheduler);
+    profiler_end_tick(&profiler, scheduler.samples_us[(scheduler.sample_count - 1) % TICK_SAMPLE_COUNT]);
+
+    if (replay_recording() && scheduler.tick % REPLAY_CHECKSUM_INTERVAL == 0)
+    {
+        replay_record_checksum(scheduler.tick, server_state_checksum(&player_map));
+    }
+}
+
+// Feed a replay log through the simulation as fast as it will go, checking
+// the recorded state checksums on the way. Returns false if the outcome
+// differs from the recording or the log is damaged.
+static bool run_replay(ReplayReader *reader)
+{
+    // Stand-in peers, indexed by the player id each recorded client got
+    ENetPeer *peers = calloc(server_config.max_players, sizeof(ENetPeer));
+    if (!peers)
+    {
+        LOG_ERROR("Failed to allocate replay peers");
+        return false;
+    }
+
+    tick_init(&scheduler, server_config.tick_rate);
+    profiler_init(&profiler, scheduler.tick);
+    uint64_t started = tick_clock_us();
+    uint32_t checksums = 0;
+    uint32_t mismatches = 0;
+    bool ended = false;
+    ReplayRecord record;
+
+    while (running && !ended && replay_next(reader, &record))
+    {
+        while (running && scheduler.tick < record.tick)
+        {
+            run_tick();
+            acknowledge_all_snapshots(&player_map);
+        }
+        if ((record.type == REPLAY_CONNECT || record.type == REPLAY_DISCONNECT ||
+             record.type == REPLAY_INPUT) &&
+            (record.player_id < 0 || record.player_id >= server_config.max_players))
+        {
+            LOG_ERROR("Replay names player %d, past the %d player slots", record.player_id,
+                      server_config.max_players);
+            break;
+        }
+
+        ENetEvent event = {0};
+        event.peer = &peers[record.player_id];
+        switch (record.type)
+        {
+        case REPLAY_CONNECT:
+        {
+            event.type = ENET_EVENT_TYPE_CONNECT;
+            dispatch_event(&event);
+            PeerPlayerEntry *entry = player_map_from_peer(&player_map, event.peer);
+            if (!entry || entry->player.id != record.player_id)
+            {
+                LOG_WARN("Recorded player %d joined as %d", record.player_id, entry ? entry->player.id : -1);
+            }
+            break;
+        }
+        case REPLAY_DISCONNECT:
+            event.type = ENET_EVENT_TYPE_DISCONNECT;
+            dispatch_event(&event);
+            break;
+        case REPLAY_INPUT:
+        {
+            PeerPlayerEntry *entry = player_map_from_peer(&player_map, event.peer);
+            if (entry)
+            {
+                queue_player_input(entry->player.id, record.commands, record.command_count);
+            }
+            break;
+        }
+        case REPLAY_CHECKSUM:
+            checksums++;
+            if (server_state_checksum(&player_map) != record.checksum)
+            {
+                if (mismatches == 0)
+                {
+                    LOG_ERROR("Replay diverged from the recording at tick %u", record.tick);
+                }
+                mismatches++;
+            }
+            break;
+        case REPLAY_TILE:
+            server_set_tile(record.tile_x, record.tile_y, record.tile_id);
+            break;
+        case REPLAY_END:
+            ended = true;
+            break;
+        }
+    }
+    if (!ended && running)
+    {
+        LOG_WARN("Replay log ended without an end marker; it may be truncated");
+    }
+
+    double seconds = (tick_clock_us() - started) / 1000000.0;
+    LOG_INFO("Replayed %u ticks in %.2f s (%.0f ticks per second), %u of %u checksums matched",
+             scheduler.tick, seconds, seconds > 0 ? scheduler.tick / seconds : 0.0,
+             checksums - mismatches, checksums);
+    free(peers);
+    return mismatches == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (!parse_args(argc, argv, &server_config)) {
+        exit(1);
+    }
+    // Move log output off the tick thread
+    log_init();
+
     // Set up signal handlers for graceful shutdown
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+#ifdef SIGUSR1
+    signal(SIGUSR1, profile_signal_handler);
+#endif
+#ifdef SIGHUP
+    signal(SIGHUP, map_reload_signal_handler);
+#endif
+
+    // A replay runs with the settings it was recorded with
+    ReplayReader replay;
+    uint32_t seed = (uint32_t)time(NULL);
+    if (server_config.replay_file)
+    {
+        if (!replay_open(&replay, server_config.replay_file))
+        {
+            exit(1);
+        }
+        seed = replay.header.seed;
+        server_config.tick_rate = replay.header.tick_rate;
+        server_config.max_players = replay.header.max_players;
+        server_config.aoi_radius = replay.header.aoi_radius;
+        server_config.enemies = replay.header.enemies;
+        server_config.net_thread = false;
+        server_config.record_file = NULL;
+    }
+    srand(seed);
 
-    if (!load_map_from_file("map.txt")) {
+    if (!load_map_from_file(server_config.map_file)) {
+        exit(1);
+    }
+    if (server_config.replay_file &&
+        ((uint32_t)world.width != replay.header.world_width || (uint32_t)world.height != replay.header.world_height))
+    {
+        LOG_ERROR("Replay was recorded on a %ux%u map, %s is %dx%d", replay.header.world_width,
+                  replay.header.world_height, server_config.map_file, world.width, world.height);
         exit(1);
     }
     // Initialize the server
     init_server(&player_map);
 
+    if (server_config.replay_file)
+    {
+        bool matched = run_replay(&replay);
+        replay_close(&replay);
+        tick_print_stats(&scheduler);
+        profiler_dump(&profiler, server_config.profile_file, scheduler.tick);
+        cleanup_server();
+        log_shutdown();
+        return matched ? 0 : 1;
+    }
+    if (server_config.record_file)
+    {
+        ReplayHeader header = {seed, server_config.tick_rate, server_config.max_players,
+                               server_config.aoi_radius, server_config.enemies, world.width,
+                               world.height};
+        if (!replay_start_recording(server_config.record_file, &header))
+        {
+            exit(1);
+        }
+    }
+
     // Run the server
-    printf("Server started. Press Ctrl+C to stop.\n");
+    LOG_INFO("Server started at %u ticks per second. Press Ctrl+C to stop.",
+             server_config.tick_rate);
 
-    float last_time = 0;
+    tick_init(&scheduler, server_config.tick_rate);
+    profiler_init(&profiler, scheduler.tick);
+    enet_uint32 last_profile_dump = enet_time_get();
     // Main server loop
 
-    printf("Server running...\n");
+    LOG_INFO("Server running...");
     while (running)
     {
-        // Check for incoming events and process them
-        process_events();
-        //broadcast_game_state();
-        // Broadcast updated player positions
-        broadcast_player_positions(&player_map);
-        //  add some sleep to avoid busy waiting
+        // Sleep in ENet until the next tick, handling events as they arrive
+        process_events(tick_next_deadline(&scheduler));
+
+        // Run the fixed step and send one snapshot for this tick
+        run_tick();
+
+        // Periodic reports start a new window; a report on demand does not
+        enet_uint32 now = enet_time_get();
+        if (server_config.profile_interval > 0 &&
+            ENET_TIME_DIFFERENCE(now, last_profile_dump) >= (enet_uint32)server_config.profile_interval * 1000)
+        {
+            profiler_dump(&profiler, server_config.profile_file, scheduler.tick);
+            profiler_init(&profiler, scheduler.tick);
+            last_profile_dump = now;
+        }
+        else if (profile_dump_requested)
+        {
+            profile_dump_requested = 0;
+            if (profiler_dump(&profiler, server_config.profile_file, scheduler.tick))
+            {
+                LOG_INFO("Wrote profiler report to %s", server_config.profile_file);
+            }
+        }
+
+        // Changed tiles go out with the next tick
+        if (map_reload_requested)
+        {
+            map_reload_requested = 0;
+            reload_map(server_config.map_file);
+        }
     }
 
+    LOG_INFO("Shutting down...");
+    replay_stop_recording(scheduler.tick);
+    tick_print_stats(&scheduler);
+    profiler_dump(&profiler, server_config.profile_file, scheduler.tick);
+
     // Clean up
     cleanup_server();
+    log_shutdown();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,342 @@
+#include "mapfile.h"
+#include "../../common/src/log.h"
+#include "../../common/src/tiles.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read the next whitespace separated number from a text map.
+// Returns false at end of file; *end_of_row is set when a newline preceded it.
+static bool read_map_token(FILE *file, int *value, bool *end_of_row)
+{
+  int c;
+  *end_of_row = false;
+  while ((c = fgetc(file)) != EOF && (c < '0' || c > '9'))
+  {
+    if (c == '\n')
+    {
+      *end_of_row = true;
+    }
+  }
+  if (c == EOF)
+  {
+    return false;
+  }
+
+  *value = 0;
+  do
+  {
+    *value = *value * 10 + (c - '0');
+  } while ((c = fgetc(file)) != EOF && c >= '0' && c <= '9');
+  if (c == '\n')
+  {
+    ungetc(c, file);
+  }
+  return true;
+}
+
+// Load a text map: one row of tile ids per line, any size
+bool map_load_text(World *world, const char *filename)
+{
+  FILE *file = fopen(filename, "r");
+  if (!file)
+  {
+    LOG_ERROR("Failed to open map file: %s", filename);
+    return false;
+  }
+
+  // First pass: the map is as wide as its longest row
+  int width = 0;
+  int height = 0;
+  int x = 0;
+  int tile_value;
+  bool end_of_row;
+  while (read_map_token(file, &tile_value, &end_of_row))
+  {
+    if (end_of_row || height == 0)
+    {
+      height++;
+      x = 0;
+    }
+    x++;
+    if (x > width)
+    {
+      width = x;
+    }
+  }
+
+  if (width == 0 || !world_init(world, width, height))
+  {
+    LOG_ERROR("Map file %s is empty or too large", filename);
+    fclose(file);
+    return false;
+  }
+
+  // Second pass: fill the world
+  rewind(file);
+  int y = -1;
+  while (read_map_token(file, &tile_value, &end_of_row))
+  {
+    if (end_of_row || y < 0)
+    {
+      y++;
+      x = 0;
+    }
+    Tile tile = tile_from_id(tile_value);
+    world_set_tile(world, x, y, tile);
+
+    // Debug output for the first few tiles
+    if (x < 3 && y < 3)
+    {
+      LOG_DEBUG("Loaded tile at (%d, %d): id=%d, walkable=%d", x, y,
+                tile.tile_id, tile.walkable);
+    }
+    x++;
+  }
+
+  fclose(file);
+  return true;
+}
+
+// Check whether a file starts with the binary map magic
+bool map_file_is_binary(const char *filename)
+{
+  char magic[4];
+  FILE *file = fopen(filename, "rb");
+  if (!file)
+  {
+    return false;
+  }
+  bool binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                memcmp(magic, MAP_FILE_MAGIC, sizeof(magic)) == 0;
+  fclose(file);
+  return binary;
+}
+
+// Map a whole file into memory, copy-on-write so runtime tile edits stay private
+static void *map_file_contents(const char *filename, size_t *size)
+{
+#ifdef _WIN32
+  // No mmap here: read the file into one block instead
+  FILE *file = fopen(filename, "rb");
+  if (!file)
+  {
+    return NULL;
+  }
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  rewind(file);
+  void *data = length > 0 ? malloc(length) : NULL;
+  if (!data || fread(data, 1, length, file) != (size_t)length)
+  {
+    free(data);
+    fclose(file);
+    return NULL;
+  }
+  fclose(file);
+  *size = length;
+  return data;
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+  {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    close(fd);
+    return NULL;
+  }
+  void *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    return NULL;
+  }
+  // Players only touch the chunks around them
+  madvise(data, st.st_size, MADV_RANDOM);
+  *size = st.st_size;
+  return data;
+#endif
+}
+
+static void unmap_file_contents(void *data, size_t size)
+{
+#ifdef _WIN32
+  free(data);
+#else
+  munmap(data, size);
+#endif
+}
+
+// Load a binary map. The world's chunk table points straight into the mapped
+// file, so no tile data is copied and chunks are only paged in when used.
+bool map_load_binary(World *world, const char *filename)
+{
+  size_t size = 0;
+  char *data = map_file_contents(filename, &size);
+  if (!data)
+  {
+    LOG_ERROR("Failed to map map file: %s", filename);
+    return false;
+  }
+
+  MapFileHeader header;
+  if (size < sizeof(header))
+  {
+    LOG_ERROR("Map file %s is truncated", filename);
+    unmap_file_contents(data, size);
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+
+  if (memcmp(header.magic, MAP_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != MAP_FILE_VERSION)
+  {
+    LOG_ERROR("Map file %s has an unsupported format or version", filename);
+    unmap_file_contents(data, size);
+    return false;
+  }
+  if (header.chunk_size != CHUNK_SIZE || header.tile_size != sizeof(Tile))
+  {
+    LOG_ERROR("Map file %s was built for chunk size %u, this server uses %d; reconvert it",
+              filename, header.chunk_size, CHUNK_SIZE);
+    unmap_file_contents(data, size);
+    return false;
+  }
+
+  uint64_t chunk_total = (uint64_t)header.chunks_x * header.chunks_y;
+  if (header.index_offset % sizeof(uint32_t) != 0 ||
+      header.index_offset + chunk_total * sizeof(uint32_t) > size)
+  {
+    LOG_ERROR("Map file %s has a corrupt chunk index", filename);
+    unmap_file_contents(data, size);
+    return false;
+  }
+  if (!world_init(world, header.width, header.height))
+  {
+    unmap_file_contents(data, size);
+    return false;
+  }
+  if ((uint32_t)world->chunks_x != header.chunks_x || (uint32_t)world->chunks_y != header.chunks_y)
+  {
+    LOG_ERROR("Map file %s has a corrupt chunk index", filename);
+    world_free(world);
+    unmap_file_contents(data, size);
+    return false;
+  }
+
+  world->mapping = data;
+  world->mapping_size = size;
+  const uint32_t *index = (const uint32_t *)(data + header.index_offset);
+  for (uint64_t i = 0; i < chunk_total; i++)
+  {
+    if (index[i] == 0)
+    {
+      continue;
+    }
+    if (index[i] % MAP_CHUNK_ALIGN != 0 || (uint64_t)index[i] + sizeof(WorldChunk) > size)
+    {
+      LOG_ERROR("Map file %s has a chunk outside the file", filename);
+      map_unload(world);
+      return false;
+    }
+    world->chunks[i] = (WorldChunk *)(data + index[i]);
+    world->allocated++;
+  }
+  return true;
+}
+
+// Write padding so the next write starts at a multiple of the alignment
+static bool write_padding(FILE *file, long alignment)
+{
+  static const char zeros[MAP_CHUNK_ALIGN] = {0};
+  long position = ftell(file);
+  long padding = (alignment - position % alignment) % alignment;
+  return fwrite(zeros, 1, padding, file) == (size_t)padding;
+}
+
+// Save a world in the binary map format
+bool map_save_binary(const World *world, const char *filename)
+{
+  FILE *file = fopen(filename, "wb");
+  if (!file)
+  {
+    LOG_ERROR("Failed to create map file: %s", filename);
+    return false;
+  }
+
+  uint32_t chunk_total = world->chunks_x * world->chunks_y;
+  uint32_t *index = calloc(chunk_total, sizeof(uint32_t));
+  if (!index)
+  {
+    fclose(file);
+    return false;
+  }
+
+  MapFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MAP_FILE_MAGIC, sizeof(header.magic));
+  header.version = MAP_FILE_VERSION;
+  header.chunk_size = CHUNK_SIZE;
+  header.tile_size = sizeof(Tile);
+  header.width = world->width;
+  header.height = world->height;
+  header.chunks_x = world->chunks_x;
+  header.chunks_y = world->chunks_y;
+  header.index_offset = sizeof(header);
+
+  // Lay out the chunk data after the index
+  long offset = header.index_offset + chunk_total * sizeof(uint32_t);
+  for (uint32_t i = 0; i < chunk_total; i++)
+  {
+    if (!world->chunks[i])
+    {
+      continue;
+    }
+    offset = (offset + MAP_CHUNK_ALIGN - 1) / MAP_CHUNK_ALIGN * MAP_CHUNK_ALIGN;
+    index[i] = offset;
+    offset += sizeof(WorldChunk);
+    header.chunk_count++;
+  }
+
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(index, sizeof(uint32_t), chunk_total, file) == chunk_total;
+  for (uint32_t i = 0; ok && i < chunk_total; i++)
+  {
+    if (world->chunks[i])
+    {
+      ok = write_padding(file, MAP_CHUNK_ALIGN) &&
+           fwrite(world->chunks[i], sizeof(WorldChunk), 1, file) == 1;
+    }
+  }
+
+  free(index);
+  if (fclose(file) != 0 || !ok)
+  {
+    LOG_ERROR("Failed to write map file: %s", filename);
+    return false;
+  }
+  return true;
+}
+
+// Free a world along with the map file backing it
+void map_unload(World *world)
+{
+  void *mapping = world->mapping;
+  size_t mapping_size = world->mapping_size;
+  world_free(world);
+  if (mapping)
+  {
+    unmap_file_contents(mapping, mapping_size);
+    world->mapping = NULL;
+    world->mapping_size = 0;
+  }
+}
@@ -0,0 +1,37 @@
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "world.h"
+
+// Binary map layout (all fields little-endian):
+//   MapFileHeader
+//   chunk index: chunks_x * chunks_y uint32 offsets, row-major, 0 = empty chunk
+//   chunk data: one WorldChunk per stored chunk, each aligned to MAP_CHUNK_ALIGN
+// Chunks are stored in the in-memory WorldChunk layout so a mapped file can
+// back the world directly.
+#define MAP_FILE_MAGIC "NGMP"
+#define MAP_FILE_VERSION 1
+#define MAP_CHUNK_ALIGN 64
+
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t chunk_size;
+  uint32_t tile_size;     // sizeof(Tile) the file was written with
+  uint32_t width;         // Size in tiles
+  uint32_t height;
+  uint32_t chunks_x;      // Size in chunks
+  uint32_t chunks_y;
+  uint32_t chunk_count;   // Number of stored (non-empty) chunks
+  uint32_t index_offset;  // File offset of the chunk index
+} MapFileHeader;
+
+bool map_file_is_binary(const char *filename);
+bool map_load_text(World *world, const char *filename);
+bool map_load_binary(World *world, const char *filename);
+bool map_save_binary(const World *world, const char *filename);
+void map_unload(World *world);
+
+#endif // MAPFILE_H
@@ -0,0 +1,300 @@
+#include "net.h"
+#include "spsc_queue.h"
+#include "../../common/src/log.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// How long the network thread waits in ENet for traffic; bounds the delay
+// before queued outgoing packets are sent
+#define NET_SERVICE_TIMEOUT_MS 1
+// How long the simulation thread sleeps while waiting for events
+#define NET_POLL_SLEEP_US 250
+
+typedef enum {
+  NET_COMMAND_SEND,
+  NET_COMMAND_BROADCAST,
+  NET_COMMAND_DISCONNECT,
+} NetCommandType;
+
+// Work the simulation thread hands to the network thread. connect_id names
+// the connection the simulation meant: ENet hands a freed peer slot to the
+// next client, which must not receive what was queued for the previous one.
+typedef struct {
+  NetCommandType type;
+  ENetPeer *peer;
+  ENetPacket *packet;
+  enet_uint8 channel;
+  enet_uint32 connect_id;
+} NetCommand;
+
+// Event handed to the simulation thread, with the connection it belongs to
+// read while the network thread still owns the peer
+typedef struct {
+  ENetEvent event;
+  enet_uint32 connect_id;
+} NetEvent;
+
+static ENetHost *net_host;
+static bool net_threaded = false;
+static SpscQueue inbound;  // ENetEvents, network thread to simulation
+static SpscQueue outbound; // NetCommands, simulation to network thread
+static atomic_bool net_running;
+static pthread_t net_thread;
+// Connection the simulation last saw connect in each peer slot; only the
+// simulation thread touches it
+static enet_uint32 *peer_connect_ids;
+
+static void sleep_us(unsigned us)
+{
+#ifdef _WIN32
+  Sleep(us < 1000 ? 1 : us / 1000);
+#else
+  usleep(us);
+#endif
+}
+
+// Whether a command's peer is still the connection it was queued for. The
+// peer may have dropped, or its slot been taken by a new client, meanwhile.
+static bool command_peer_current(const NetCommand *command)
+{
+  return command->peer->state == ENET_PEER_STATE_CONNECTED &&
+         command->peer->connectID == command->connect_id;
+}
+
+static void run_command(const NetCommand *command)
+{
+  switch (command->type)
+  {
+  case NET_COMMAND_SEND:
+    if (!command_peer_current(command) ||
+        enet_peer_send(command->peer, command->channel, command->packet) != 0)
+    {
+      enet_packet_destroy(command->packet);
+    }
+    break;
+  case NET_COMMAND_BROADCAST:
+    enet_host_broadcast(net_host, command->channel, command->packet);
+    break;
+  case NET_COMMAND_DISCONNECT:
+    if (command_peer_current(command))
+    {
+      enet_peer_disconnect(command->peer, 0);
+    }
+    break;
+  }
+}
+
+// Send everything the simulation queued so far
+static void drain_outbound(void)
+{
+  NetCommand command;
+  while (spsc_queue_pop(&outbound, &command))
+  {
+    run_command(&command);
+  }
+}
+
+static void push_inbound(const ENetEvent *event)
+{
+  NetEvent queued = {*event, event->peer ? event->peer->connectID : 0};
+  while (!spsc_queue_push(&inbound, &queued))
+  {
+    // Falling behind this far means the simulation is stalled; keep the
+    // event rather than lose a connect or disconnect
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 1, "Network inbound queue full, waiting for the simulation");
+    drain_outbound();
+    sleep_us(NET_POLL_SLEEP_US);
+  }
+}
+
+static void *net_thread_main(void *arg)
+{
+  (void)arg;
+  ENetEvent event;
+  while (atomic_load_explicit(&net_running, memory_order_relaxed))
+  {
+    drain_outbound();
+    if (enet_host_service(net_host, &event, NET_SERVICE_TIMEOUT_MS) > 0)
+    {
+      do
+      {
+        push_inbound(&event);
+      } while (enet_host_check_events(net_host, &event) > 0);
+    }
+  }
+  drain_outbound();
+  enet_host_flush(net_host);
+  return NULL;
+}
+
+static void push_outbound(const NetCommand *command)
+{
+  while (!spsc_queue_push(&outbound, command))
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 1, "Network outbound queue full, waiting for the network thread");
+    sleep_us(NET_POLL_SLEEP_US);
+  }
+}
+
+// Start routing ENet traffic for a host, optionally on its own thread.
+// Without a host (replays) nothing arrives and everything sent is dropped.
+bool net_init(ENetHost *host, bool threaded)
+{
+  net_host = host;
+  net_threaded = threaded && host;
+  if (!net_threaded)
+  {
+    return true;
+  }
+
+  peer_connect_ids = calloc(host->peerCount, sizeof(enet_uint32));
+  if (!peer_connect_ids ||
+      !spsc_queue_init(&inbound, NET_INBOUND_CAPACITY, sizeof(NetEvent)) ||
+      !spsc_queue_init(&outbound, NET_OUTBOUND_CAPACITY, sizeof(NetCommand)))
+  {
+    LOG_ERROR("Failed to allocate network queues");
+    spsc_queue_free(&inbound);
+    free(peer_connect_ids);
+    peer_connect_ids = NULL;
+    net_threaded = false;
+    return false;
+  }
+  atomic_store(&net_running, true);
+  if (pthread_create(&net_thread, NULL, net_thread_main, NULL) != 0)
+  {
+    LOG_ERROR("Failed to start network thread");
+    spsc_queue_free(&inbound);
+    spsc_queue_free(&outbound);
+    free(peer_connect_ids);
+    peer_connect_ids = NULL;
+    net_threaded = false;
+    return false;
+  }
+  LOG_INFO("Network thread started");
+  return true;
+}
+
+// Stop the network thread after it has sent what is still queued
+void net_shutdown(void)
+{
+  if (!net_threaded)
+  {
+    return;
+  }
+  atomic_store(&net_running, false);
+  pthread_join(net_thread, NULL);
+
+  // Release packets nobody will handle any more
+  NetEvent queued;
+  while (spsc_queue_pop(&inbound, &queued))
+  {
+    if (queued.event.type == ENET_EVENT_TYPE_RECEIVE)
+    {
+      enet_packet_destroy(queued.event.packet);
+    }
+  }
+  spsc_queue_free(&inbound);
+  spsc_queue_free(&outbound);
+  free(peer_connect_ids);
+  peer_connect_ids = NULL;
+  net_threaded = false;
+}
+
+// Wait up to timeout_ms for the next event; the caller owns received packets
+bool net_poll(ENetEvent *event, enet_uint32 timeout_ms)
+{
+  if (!net_host)
+  {
+    return false;
+  }
+  if (!net_threaded)
+  {
+    return enet_host_service(net_host, event, timeout_ms) > 0;
+  }
+
+  enet_uint32 deadline = enet_time_get() + timeout_ms;
+  NetEvent queued;
+  while (!spsc_queue_pop(&inbound, &queued))
+  {
+    if (!ENET_TIME_LESS(enet_time_get(), deadline))
+    {
+      return false;
+    }
+    sleep_us(NET_POLL_SLEEP_US);
+  }
+  *event = queued.event;
+  if (event->type == ENET_EVENT_TYPE_CONNECT)
+  {
+    peer_connect_ids[event->peer - net_host->peers] = queued.connect_id;
+  }
+  return true;
+}
+
+void net_send(ENetPeer *peer, enet_uint8 channel, ENetPacket *packet)
+{
+  if (!net_host)
+  {
+    enet_packet_destroy(packet);
+    return;
+  }
+  if (!net_threaded)
+  {
+    // A refused packet is never queued, so nothing else would free it
+    if (enet_peer_send(peer, channel, packet) != 0)
+    {
+      enet_packet_destroy(packet);
+    }
+    return;
+  }
+  NetCommand command = {NET_COMMAND_SEND, peer, packet, channel,
+                        peer_connect_ids[peer - net_host->peers]};
+  push_outbound(&command);
+}
+
+void net_broadcast(enet_uint8 channel, ENetPacket *packet)
+{
+  if (!net_host)
+  {
+    enet_packet_destroy(packet);
+    return;
+  }
+  if (!net_threaded)
+  {
+    enet_host_broadcast(net_host, channel, packet);
+    return;
+  }
+  NetCommand command = {NET_COMMAND_BROADCAST, NULL, packet, channel, 0};
+  push_outbound(&command);
+}
+
+void net_disconnect(ENetPeer *peer)
+{
+  if (!net_host)
+  {
+    return;
+  }
+  if (!net_threaded)
+  {
+    enet_peer_disconnect(peer, 0);
+    return;
+  }
+  NetCommand command = {NET_COMMAND_DISCONNECT, peer, NULL, 0,
+                        peer_connect_ids[peer - net_host->peers]};
+  push_outbound(&command);
+}
+
+// Push queued packets to the socket now. The network thread does this on
+// its own within NET_SERVICE_TIMEOUT_MS.
+void net_flush(void)
+{
+  if (net_host && !net_threaded)
+  {
+    enet_host_flush(net_host);
+  }
+}
@@ -0,0 +1,25 @@
+#ifndef NET_H
+#define NET_H
+
+#include <enet/enet.h>
+#include <stdbool.h>
+
+// Queue sizes for the network thread; a full queue makes the producer wait
+#define NET_INBOUND_CAPACITY 4096
+#define NET_OUTBOUND_CAPACITY 8192
+
+// All ENet access from the game goes through here. Without a network thread
+// these call ENet directly. With one, a dedicated thread owns the host: it
+// services ENet continuously and hands events to the simulation thread and
+// takes outgoing packets back through two single-producer/single-consumer
+// queues, so a slow tick never delays receiving and a packet burst never
+// delays the tick.
+bool net_init(ENetHost *host, bool threaded);
+void net_shutdown(void);
+bool net_poll(ENetEvent *event, enet_uint32 timeout_ms);
+void net_send(ENetPeer *peer, enet_uint8 channel, ENetPacket *packet);
+void net_broadcast(enet_uint8 channel, ENetPacket *packet);
+void net_disconnect(ENetPeer *peer);
+void net_flush(void);
+
+#endif // NET_H
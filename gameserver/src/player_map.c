@@ -0,0 +1,149 @@
+#include "player_map.h"
+#include "../../common/src/log.h"
+#include <stddef.h>
+#include <stdlib.h>
+
+// Allocate an empty table with room for capacity players; every id starts out free
+bool player_map_init(ServerPlayerMap *map, int capacity)
+{
+  map->entries = calloc(capacity, sizeof(PeerPlayerEntry));
+  map->generations = calloc(capacity, sizeof(uint16_t));
+  map->free_slots = calloc(capacity, sizeof(int));
+  map->active = calloc(capacity, sizeof(int));
+  map->active_index = calloc(capacity, sizeof(int));
+  if (!map->entries || !map->generations || !map->free_slots || !map->active ||
+      !map->active_index)
+  {
+    LOG_ERROR("Failed to allocate player table for %d players", capacity);
+    player_map_destroy(map);
+    return false;
+  }
+
+  map->capacity = capacity;
+  map->count = 0;
+  map->free_head = 0;
+  map->free_count = capacity;
+  for (int i = 0; i < capacity; i++)
+  {
+    map->entries[i].peer = NULL;
+    map->entries[i].player.active = false;
+    map->entries[i].player.id = -1;
+    // Generations start at 1 so PLAYER_HANDLE_NONE never resolves
+    map->generations[i] = 1;
+    map->free_slots[i] = i;
+    map->active_index[i] = -1;
+  }
+  return true;
+}
+
+void player_map_destroy(ServerPlayerMap *map)
+{
+  free(map->entries);
+  free(map->generations);
+  free(map->free_slots);
+  free(map->active);
+  free(map->active_index);
+  map->entries = NULL;
+  map->generations = NULL;
+  map->free_slots = NULL;
+  map->active = map->active_index = NULL;
+  map->capacity = map->count = map->free_count = 0;
+}
+
+// Take a free slot for a new peer. Ids are reused oldest first, so a leaving
+// player's id stays out of circulation for as long as possible.
+PeerPlayerEntry *player_map_alloc(ServerPlayerMap *map, ENetPeer *peer)
+{
+  if (map->free_count == 0)
+  {
+    return NULL;
+  }
+  int id = map->free_slots[map->free_head];
+  map->free_head = (map->free_head + 1) % map->capacity;
+  map->free_count--;
+
+  map->active_index[id] = map->count;
+  map->active[map->count++] = id;
+
+  PeerPlayerEntry *entry = &map->entries[id];
+  entry->peer = peer;
+  entry->player.id = id;
+  entry->player.active = true;
+  peer->data = entry;
+  return entry;
+}
+
+// Release a slot and invalidate every handle to it
+void player_map_free(ServerPlayerMap *map, PeerPlayerEntry *entry)
+{
+  int id = entry->player.id;
+  if (id < 0 || id >= map->capacity || map->active_index[id] < 0)
+  {
+    return;
+  }
+
+  // Swap the last active id into the hole
+  int index = map->active_index[id];
+  int last = map->active[--map->count];
+  map->active[index] = last;
+  map->active_index[last] = index;
+  map->active_index[id] = -1;
+
+  if (entry->peer && entry->peer->data == entry)
+  {
+    entry->peer->data = NULL;
+  }
+  entry->peer = NULL;
+  entry->player.active = false;
+  entry->player.id = -1;
+  map->generations[id]++;
+  if (map->generations[id] == 0)
+  {
+    map->generations[id] = 1;
+  }
+
+  map->free_slots[(map->free_head + map->free_count) % map->capacity] = id;
+  map->free_count++;
+}
+
+// Entry a peer belongs to, NULL if it never got a slot or already left
+PeerPlayerEntry *player_map_from_peer(const ServerPlayerMap *map, const ENetPeer *peer)
+{
+  PeerPlayerEntry *entry = peer->data;
+  if (!entry || entry < map->entries || entry >= map->entries + map->capacity ||
+      entry->peer != peer || !entry->player.active)
+  {
+    return NULL;
+  }
+  return entry;
+}
+
+PeerPlayerEntry *player_map_get(ServerPlayerMap *map, int id)
+{
+  if (id < 0 || id >= map->capacity || !map->entries[id].player.active)
+  {
+    return NULL;
+  }
+  return &map->entries[id];
+}
+
+// Handle to the player currently using an id
+PlayerHandle player_map_handle(const ServerPlayerMap *map, int id)
+{
+  if (id < 0 || id >= map->capacity || map->active_index[id] < 0)
+  {
+    return PLAYER_HANDLE_NONE;
+  }
+  return (PlayerHandle)map->generations[id] << 16 | (PlayerHandle)id;
+}
+
+// Player a handle refers to, NULL once that player has left
+PeerPlayerEntry *player_map_resolve(ServerPlayerMap *map, PlayerHandle handle)
+{
+  int id = handle & 0xFFFF;
+  if (id >= map->capacity || map->generations[id] != handle >> 16)
+  {
+    return NULL;
+  }
+  return player_map_get(map, id);
+}
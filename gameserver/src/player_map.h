@@ -0,0 +1,38 @@
+#ifndef PLAYER_MAP_H
+#define PLAYER_MAP_H
+
+#include <enet/enet.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "../../common/src/common.h"
+
+// Reference to a player slot that goes stale once the player leaves:
+// slot index in the low 16 bits, slot generation in the high 16 bits
+typedef uint32_t PlayerHandle;
+#define PLAYER_HANDLE_NONE 0
+
+// Slot table of connected players. A player's id is its slot index and stays
+// the same for the whole connection; peer->data points back at the entry so
+// packets find their player without a search.
+typedef struct {
+  PeerPlayerEntry *entries; // Indexed by player id
+  uint16_t *generations;    // Bumped each time a slot is freed
+  int *free_slots;          // Queue of unused ids, oldest first
+  int free_head;
+  int free_count;
+  int *active;              // Ids in use, packed for iteration
+  int *active_index;        // Position of each id in active, -1 if free
+  int count;                // Number of ids in use
+  int capacity;             // Number of slots, fixed at startup
+} ServerPlayerMap;
+
+bool player_map_init(ServerPlayerMap *map, int capacity);
+void player_map_destroy(ServerPlayerMap *map);
+PeerPlayerEntry *player_map_alloc(ServerPlayerMap *map, ENetPeer *peer);
+void player_map_free(ServerPlayerMap *map, PeerPlayerEntry *entry);
+PeerPlayerEntry *player_map_from_peer(const ServerPlayerMap *map, const ENetPeer *peer);
+PeerPlayerEntry *player_map_get(ServerPlayerMap *map, int id);
+PlayerHandle player_map_handle(const ServerPlayerMap *map, int id);
+PeerPlayerEntry *player_map_resolve(ServerPlayerMap *map, PlayerHandle handle);
+
+#endif // PLAYER_MAP_H
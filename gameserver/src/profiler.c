@@ -0,0 +1,129 @@
+#include "profiler.h"
+#include "tick.h"
+#include "../../common/src/common.h"
+#include "../../common/src/log.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char *phase_names[PROFILE_PHASE_COUNT] = {
+  "events", "simulation", "ai", "chunks", "snapshots", "send", "tick",
+};
+
+// Name of a packet type for the dump, NULL for unknown types
+static const char *packet_name(int type)
+{
+  switch (type)
+  {
+  case PKT_TILE_CHUNK: return "tile_chunk";
+  case PKT_PLAYER_ID: return "player_id";
+  case PKT_ADD_PLAYER: return "add_player";
+  case PKT_REMOVE_PLAYER: return "remove_player";
+  case PKT_SNAPSHOT: return "snapshot";
+  case PKT_SNAPSHOT_ACK: return "snapshot_ack";
+  case PKT_UNLOAD_CHUNK: return "unload_chunk";
+  case PKT_INPUT: return "input";
+  case PKT_STATS_REQUEST: return "stats_request";
+  case PKT_SERVER_STATS: return "server_stats";
+  case PKT_TILE_DELTA: return "tile_delta";
+  case PKT_CHUNK_REQUEST: return "chunk_request";
+  default: return NULL;
+  }
+}
+
+// Start a new window at the given tick
+void profiler_init(Profiler *p, uint32_t tick)
+{
+  for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+  {
+    histogram_reset(&p->phases[i]);
+    p->tick_us[i] = 0;
+  }
+  memset(p->received, 0, sizeof(p->received));
+  memset(p->sent, 0, sizeof(p->sent));
+  p->window_start_tick = tick;
+  p->window_start_us = tick_clock_us();
+}
+
+// Charge time to a phase of the running tick
+void profiler_add(Profiler *p, ProfilePhase phase, uint64_t elapsed_us)
+{
+  p->tick_us[phase] += elapsed_us;
+}
+
+// Record the running tick's phase times and start on the next tick
+void profiler_end_tick(Profiler *p, uint32_t tick_us)
+{
+  p->tick_us[PROFILE_TICK] = tick_us;
+  for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+  {
+    uint64_t us = p->tick_us[i];
+    histogram_record(&p->phases[i], us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+    p->tick_us[i] = 0;
+  }
+}
+
+void profiler_count_received(Profiler *p, uint8_t type, size_t bytes)
+{
+  p->received[type].packets++;
+  p->received[type].bytes += bytes;
+}
+
+// Count a packet going out; a broadcast counts once per receiving peer
+void profiler_count_sent(Profiler *p, uint8_t type, size_t bytes, size_t copies)
+{
+  p->sent[type].packets += copies;
+  p->sent[type].bytes += bytes * copies;
+}
+
+// Append a report of the current window to a file
+bool profiler_dump(const Profiler *p, const char *path, uint32_t tick)
+{
+  FILE *file = fopen(path, "a");
+  if (!file)
+  {
+    LOG_WARN("Failed to open profile file %s", path);
+    return false;
+  }
+
+  double seconds = (tick_clock_us() - p->window_start_us) / 1000000.0;
+  char timestamp[32];
+  time_t now = time(NULL);
+  strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+  fprintf(file, "== %s ticks %u-%u (%.1f s) ==\n", timestamp, p->window_start_tick, tick,
+          seconds);
+
+  fprintf(file, "%-12s %8s %9s %9s %9s %9s %9s (us per tick)\n", "phase", "ticks", "mean",
+          "p50", "p90", "p99", "max");
+  for (int i = 0; i < PROFILE_PHASE_COUNT; i++)
+  {
+    const Histogram *h = &p->phases[i];
+    fprintf(file, "%-12s %8llu %9.1f %9u %9u %9u %9u\n", phase_names[i],
+            (unsigned long long)h->count, histogram_mean(h), histogram_percentile(h, 50),
+            histogram_percentile(h, 90), histogram_percentile(h, 99), h->max);
+  }
+
+  fprintf(file, "%-18s %10s %12s %10s %12s\n", "packet", "received", "bytes", "sent", "bytes");
+  for (int type = 0; type < 256; type++)
+  {
+    const PacketCounter *in = &p->received[type];
+    const PacketCounter *out = &p->sent[type];
+    if (in->packets == 0 && out->packets == 0)
+    {
+      continue;
+    }
+    const char *name = packet_name(type);
+    char unknown[16];
+    if (!name)
+    {
+      snprintf(unknown, sizeof(unknown), "0x%02x", type);
+      name = unknown;
+    }
+    fprintf(file, "%-18s %10llu %12llu %10llu %12llu\n", name,
+            (unsigned long long)in->packets, (unsigned long long)in->bytes,
+            (unsigned long long)out->packets, (unsigned long long)out->bytes);
+  }
+  fprintf(file, "\n");
+  fclose(file);
+  return true;
+}
@@ -0,0 +1,44 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "histogram.h"
+
+// Parts of a server tick that are timed separately
+typedef enum {
+  PROFILE_EVENTS,     // Handling ENet events that arrived since the last tick
+  PROFILE_SIMULATION, // Applying buffered input
+  PROFILE_AI,         // Moving enemies along their flow fields
+  PROFILE_CHUNKS,     // Streaming map chunks
+  PROFILE_SNAPSHOTS,  // Building and delta encoding snapshots
+  PROFILE_SEND,       // Queueing packets and flushing them to the socket
+  PROFILE_TICK,       // The whole fixed step, events excluded
+  PROFILE_PHASE_COUNT
+} ProfilePhase;
+
+typedef struct {
+  uint64_t packets;
+  uint64_t bytes;
+} PacketCounter;
+
+// Per-tick phase timings and traffic by packet type, collected over a
+// window that is dumped and restarted periodically
+typedef struct {
+  Histogram phases[PROFILE_PHASE_COUNT]; // Microseconds per tick
+  uint64_t tick_us[PROFILE_PHASE_COUNT]; // Time spent in the running tick
+  PacketCounter received[256];           // Indexed by packet type
+  PacketCounter sent[256];
+  uint32_t window_start_tick;
+  uint64_t window_start_us;
+} Profiler;
+
+void profiler_init(Profiler *p, uint32_t tick);
+void profiler_add(Profiler *p, ProfilePhase phase, uint64_t elapsed_us);
+void profiler_end_tick(Profiler *p, uint32_t tick_us);
+void profiler_count_received(Profiler *p, uint8_t type, size_t bytes);
+void profiler_count_sent(Profiler *p, uint8_t type, size_t bytes, size_t copies);
+bool profiler_dump(const Profiler *p, const char *path, uint32_t tick);
+
+#endif // PROFILER_H
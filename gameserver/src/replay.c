@@ -0,0 +1,265 @@
+#include "replay.h"
+#include "../../common/src/log.h"
+#include "../../common/src/wire.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Records are collected here and written out whenever less than one
+// record's worth of room is left
+#define REPLAY_BUFFER_SIZE 65536
+#define REPLAY_RECORD_MAX_SIZE (1 + 3 * VARINT_MAX_SIZE + 1 + INPUT_REDUNDANCY * (VARINT_MAX_SIZE + 1))
+
+static FILE *record_file = NULL;
+static uint8_t record_buffer[REPLAY_BUFFER_SIZE];
+static WireWriter record_writer;
+static uint32_t record_tick = 0;
+static uint64_t record_count = 0;
+
+static bool flush_records(void)
+{
+  bool ok = fwrite(record_writer.data, 1, record_writer.size, record_file) == record_writer.size;
+  wire_writer_init(&record_writer, record_buffer, sizeof(record_buffer));
+  if (!ok)
+  {
+    LOG_ERROR("Failed to write replay log; recording stopped");
+    fclose(record_file);
+    record_file = NULL;
+  }
+  return ok;
+}
+
+// Start a record with its type and tick stamp; false when not recording
+static bool begin_record(ReplayRecordType type, uint32_t tick)
+{
+  if (!record_file)
+  {
+    return false;
+  }
+  if (record_writer.capacity - record_writer.size < REPLAY_RECORD_MAX_SIZE && !flush_records())
+  {
+    return false;
+  }
+  wire_write_u8(&record_writer, type);
+  wire_write_varint(&record_writer, tick - record_tick);
+  record_tick = tick;
+  record_count++;
+  return true;
+}
+
+bool replay_start_recording(const char *path, const ReplayHeader *header)
+{
+  record_file = fopen(path, "wb");
+  if (!record_file)
+  {
+    LOG_ERROR("Failed to open replay log %s", path);
+    return false;
+  }
+  wire_writer_init(&record_writer, record_buffer, sizeof(record_buffer));
+  record_tick = 0;
+  record_count = 0;
+
+  wire_write_bytes(&record_writer, REPLAY_MAGIC, 4);
+  wire_write_u16(&record_writer, REPLAY_VERSION);
+  wire_write_u32(&record_writer, header->seed);
+  wire_write_u16(&record_writer, header->tick_rate);
+  wire_write_u16(&record_writer, header->max_players);
+  wire_write_u16(&record_writer, header->aoi_radius);
+  wire_write_u32(&record_writer, header->enemies);
+  wire_write_u32(&record_writer, header->world_width);
+  wire_write_u32(&record_writer, header->world_height);
+  LOG_INFO("Recording replay to %s", path);
+  return true;
+}
+
+// Mark where the recording ends and close the log
+void replay_stop_recording(uint32_t tick)
+{
+  if (!begin_record(REPLAY_END, tick))
+  {
+    return;
+  }
+  if (flush_records())
+  {
+    fclose(record_file);
+    record_file = NULL;
+    LOG_INFO("Replay log closed after %llu records", (unsigned long long)record_count);
+  }
+}
+
+bool replay_recording(void)
+{
+  return record_file != NULL;
+}
+
+void replay_record_connect(uint32_t tick, int player_id)
+{
+  if (begin_record(REPLAY_CONNECT, tick))
+  {
+    wire_write_varint(&record_writer, player_id);
+  }
+}
+
+void replay_record_disconnect(uint32_t tick, int player_id)
+{
+  if (begin_record(REPLAY_DISCONNECT, tick))
+  {
+    wire_write_varint(&record_writer, player_id);
+  }
+}
+
+// Commands exactly as they were queued; each is a sequence step from the
+// previous one and one byte of direction
+void replay_record_input(uint32_t tick, int player_id, const InputCommand *commands, int count)
+{
+  if (count <= 0 || !begin_record(REPLAY_INPUT, tick))
+  {
+    return;
+  }
+  wire_write_varint(&record_writer, player_id);
+  wire_write_u8(&record_writer, (uint8_t)count);
+  uint32_t sequence = 0;
+  for (int i = 0; i < count; i++)
+  {
+    wire_write_svarint(&record_writer, (int32_t)(commands[i].sequence - sequence));
+    sequence = commands[i].sequence;
+    wire_write_u8(&record_writer, (uint8_t)((commands[i].dir_x + 1) | (commands[i].dir_y + 1) << 2));
+  }
+}
+
+void replay_record_checksum(uint32_t tick, uint64_t checksum)
+{
+  if (begin_record(REPLAY_CHECKSUM, tick))
+  {
+    wire_write_u32(&record_writer, (uint32_t)checksum);
+    wire_write_u32(&record_writer, (uint32_t)(checksum >> 32));
+  }
+}
+
+void replay_record_tile(uint32_t tick, int x, int y, unsigned char tile_id)
+{
+  if (begin_record(REPLAY_TILE, tick))
+  {
+    wire_write_varint(&record_writer, x);
+    wire_write_varint(&record_writer, y);
+    wire_write_u8(&record_writer, tile_id);
+  }
+}
+
+// Read a whole replay log and its header
+bool replay_open(ReplayReader *reader, const char *path)
+{
+  memset(reader, 0, sizeof(*reader));
+  FILE *file = fopen(path, "rb");
+  if (!file)
+  {
+    LOG_ERROR("Failed to open replay log %s", path);
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  reader->data = size > 0 ? malloc(size) : NULL;
+  if (!reader->data || fread(reader->data, 1, size, file) != (size_t)size)
+  {
+    LOG_ERROR("Failed to read replay log %s", path);
+    fclose(file);
+    replay_close(reader);
+    return false;
+  }
+  fclose(file);
+  reader->size = size;
+
+  WireReader r;
+  wire_reader_init(&r, reader->data, reader->size);
+  char magic[4];
+  wire_read_bytes(&r, magic, sizeof(magic));
+  uint16_t version = wire_read_u16(&r);
+  ReplayHeader *header = &reader->header;
+  header->seed = wire_read_u32(&r);
+  header->tick_rate = wire_read_u16(&r);
+  header->max_players = wire_read_u16(&r);
+  header->aoi_radius = wire_read_u16(&r);
+  header->enemies = wire_read_u32(&r);
+  header->world_width = wire_read_u32(&r);
+  header->world_height = wire_read_u32(&r);
+  if (r.overflow || memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 || version < 1 ||
+      version > REPLAY_VERSION)
+  {
+    LOG_ERROR("Replay log %s has an unsupported format or version", path);
+    replay_close(reader);
+    return false;
+  }
+  reader->offset = r.offset;
+  return true;
+}
+
+// Decode the next record; false at the end of the log or on a damaged record
+bool replay_next(ReplayReader *reader, ReplayRecord *record)
+{
+  if (reader->offset >= reader->size)
+  {
+    return false;
+  }
+  WireReader r;
+  wire_reader_init(&r, reader->data + reader->offset, reader->size - reader->offset);
+  record->type = wire_read_u8(&r);
+  record->tick = reader->tick + wire_read_varint(&r);
+  record->player_id = 0;
+  record->command_count = 0;
+  switch (record->type)
+  {
+  case REPLAY_CONNECT:
+  case REPLAY_DISCONNECT:
+    record->player_id = wire_read_varint(&r);
+    break;
+  case REPLAY_INPUT:
+  {
+    record->player_id = wire_read_varint(&r);
+    record->command_count = wire_read_u8(&r);
+    if (record->command_count > INPUT_REDUNDANCY)
+    {
+      return false;
+    }
+    uint32_t sequence = 0;
+    for (int i = 0; i < record->command_count; i++)
+    {
+      sequence += (uint32_t)wire_read_svarint(&r);
+      uint8_t dir = wire_read_u8(&r);
+      record->commands[i].sequence = sequence;
+      record->commands[i].dir_x = (int8_t)((dir & 3) - 1);
+      record->commands[i].dir_y = (int8_t)((dir >> 2 & 3) - 1);
+    }
+    break;
+  }
+  case REPLAY_CHECKSUM:
+    record->checksum = wire_read_u32(&r);
+    record->checksum |= (uint64_t)wire_read_u32(&r) << 32;
+    break;
+  case REPLAY_END:
+    break;
+  case REPLAY_TILE:
+    record->tile_x = wire_read_varint(&r);
+    record->tile_y = wire_read_varint(&r);
+    record->tile_id = wire_read_u8(&r);
+    break;
+  default:
+    LOG_ERROR("Unknown replay record type %d", record->type);
+    return false;
+  }
+  if (r.overflow)
+  {
+    LOG_ERROR("Replay log ends in the middle of a record");
+    return false;
+  }
+  reader->offset += r.offset;
+  reader->tick = record->tick;
+  return true;
+}
+
+void replay_close(ReplayReader *reader)
+{
+  free(reader->data);
+  reader->data = NULL;
+  reader->size = 0;
+}
@@ -0,0 +1,75 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../../common/src/input.h"
+
+// Replay log layout (little-endian, varints as in wire.h):
+//   header: magic, version, then the settings that decide the outcome
+//   records: type, ticks since the previous record, type-specific payload
+// Every record is stamped with the last tick completed before it happened,
+// so a replay applies it between that tick and the next one, exactly where
+// the live server did.
+#define REPLAY_MAGIC "NGRP"
+// Version 2 added tile edit records; version 1 logs still replay
+#define REPLAY_VERSION 2
+// A state checksum is recorded every this many ticks
+#define REPLAY_CHECKSUM_INTERVAL 20
+
+typedef enum {
+  REPLAY_CONNECT = 1,
+  REPLAY_DISCONNECT,
+  REPLAY_INPUT,
+  REPLAY_CHECKSUM,
+  REPLAY_END,
+  REPLAY_TILE,
+} ReplayRecordType;
+
+// Settings a recording was made with; a replay runs with the same ones
+typedef struct {
+  uint32_t seed;        // Random seed, decides enemy spawns
+  uint16_t tick_rate;
+  uint16_t max_players;
+  uint16_t aoi_radius;
+  uint32_t enemies;
+  uint32_t world_width; // Checked against the map the replay is given
+  uint32_t world_height;
+} ReplayHeader;
+
+typedef struct {
+  ReplayRecordType type;
+  uint32_t tick;
+  int player_id;
+  int command_count;
+  InputCommand commands[INPUT_REDUNDANCY];
+  uint64_t checksum;
+  int tile_x;           // Tile edit: position and new id
+  int tile_y;
+  unsigned char tile_id;
+} ReplayRecord;
+
+// A whole replay log read into memory
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t offset;
+  uint32_t tick;        // Stamp of the last record read
+  ReplayHeader header;
+} ReplayReader;
+
+bool replay_start_recording(const char *path, const ReplayHeader *header);
+void replay_stop_recording(uint32_t tick);
+bool replay_recording(void);
+void replay_record_connect(uint32_t tick, int player_id);
+void replay_record_disconnect(uint32_t tick, int player_id);
+void replay_record_input(uint32_t tick, int player_id, const InputCommand *commands, int count);
+void replay_record_checksum(uint32_t tick, uint64_t checksum);
+void replay_record_tile(uint32_t tick, int x, int y, unsigned char tile_id);
+
+bool replay_open(ReplayReader *reader, const char *path);
+bool replay_next(ReplayReader *reader, ReplayRecord *record);
+void replay_close(ReplayReader *reader);
+
+#endif // REPLAY_H
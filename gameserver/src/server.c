@@ -1,4 +1,22 @@
 #include "server.h"
+#include "spatial_grid.h"
+#include "chunk_stream.h"
+#include "enemies.h"
+#include "input_buffer.h"
+#include "walk_query.h"
+#include "world.h"
+#include "zones.h"
+#include "mapfile.h"
+#include "net.h"
+#include "profiler.h"
+#include "replay.h"
+#include "tick.h"
+#include "tile_edits.h"
+#include "../../common/src/chunk_codec.h"
+#include "../../common/src/log.h"
+#include "../../common/src/packet_pool.h"
+#include "../../common/src/server_stats.h"
+#include "../../common/src/tiles.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -10,9 +28,35 @@ ENetHost *server;
 ENetAddress address;
 ENetEvent event;
 
-Tile game_map[VIEWPORT_WIDTH][VIEWPORT_HEIGHT];
+World world;
+// Chunk versions and the tile edits waiting for the next tick
+TileEdits tile_edits;
 // extern global player_map, defined in main.c
 extern ServerPlayerMap player_map;
+// extern global server_config, defined in main.c
+extern ServerConfig server_config;
+// extern global scheduler, defined in main.c
+extern TickScheduler scheduler;
+// extern global profiler, defined in main.c
+extern Profiler profiler;
+// extern global entities, defined in enemies.c
+extern EntityWorld entities;
+// Per-client state below is indexed by player id and sized to --max-players
+// Snapshots sent to each client
+SnapshotHistory *client_snapshots;
+// Player positions bucketed by area, used for interest management
+SpatialGrid player_grid;
+// Chunks each client has loaded
+ChunkStream *client_streams;
+// Input commands waiting for the next tick
+InputBuffer *client_inputs;
+// Entities that changed in the last snapshot sent to each client
+int *last_snapshot_changes;
+// Worker zones; when enabled each zone's grid replaces player_grid
+ZoneSet zones;
+// Pooled snapshot buffers filled by the zone workers, sent from the main thread
+uint8_t **zone_packets;
+size_t *zone_packet_sizes;
 
 // Initialize a new player
 void init_player(Player *player, int id)
@@ -30,8 +74,19 @@ void init_player(Player *player, int id)
       {13, 13}  // Position 8
   };
 
-  // Use the player ID to determine the starting position
+  // Use the player ID to determine the starting position, moving on to the
+  // next one when the map leaves no room to stand and move there
   int position_index = id % 8;
+  for (int i = 0; i < 8; i++)
+  {
+    int x = start_positions[(id + i) % 8][0];
+    int y = start_positions[(id + i) % 8][1];
+    if (walk_rect_clear(&world, x - 1, y - 1, x + 1, y + 1))
+    {
+      position_index = (id + i) % 8;
+      break;
+    }
+  }
   player->x = start_positions[position_index][0];
   player->y = start_positions[position_index][1];
 
@@ -39,149 +94,361 @@ void init_player(Player *player, int id)
   player->active = true;
   player->color_index = id % 8; // Assign color based on player ID (8 colors available)
 
-  printf("Initialized player %d at position (%d, %d) with color %d\n", id,
-         player->x, player->y, player->color_index);
+  LOG_INFO("Initialized player %d at position (%d, %d) with color %d", id,
+           player->x, player->y, player->color_index);
+}
+
+// Send a packet to one peer, counting it by type
+static void send_packet(ENetPeer *peer, enet_uint8 channel, ENetPacket *packet)
+{
+  if (!packet)
+  {
+    return;
+  }
+  profiler_count_sent(&profiler, packet->data[0], packet->dataLength, 1);
+  net_send(peer, channel, packet);
+}
+
+// Send a packet to every connected peer, counting it once per player
+static void broadcast_packet(enet_uint8 channel, ENetPacket *packet)
+{
+  if (!packet)
+  {
+    return;
+  }
+  profiler_count_sent(&profiler, packet->data[0], packet->dataLength, player_map.count);
+  net_broadcast(channel, packet);
 }
 
 // Remove a player from the game
 void remove_player(ServerPlayerMap *map, ENetPeer *peer)
 {
-  for (int i = 0; i < map->count; i++)
+  PeerPlayerEntry *entry = player_map_from_peer(map, peer);
+  if (!entry)
   {
-    if (map->entries[i].peer == peer)
+    return;
+  }
+
+  replay_record_disconnect(scheduler.tick, entry->player.id);
+
+  // Tell everyone before the slot is released and the id is cleared
+  PlayerIdPacket pkt;
+  pkt.type = PKT_REMOVE_PLAYER;
+  pkt.player_id = entry->player.id;
+  pkt.color_index = entry->player.color_index;
+  ENetPacket *epkt = packet_pool_create(&pkt, sizeof(pkt), ENET_PACKET_FLAG_RELIABLE);
+  broadcast_packet(CHANNEL_RELIABLE, epkt);
+
+  if (zones.count > 0)
+  {
+    zone_set_remove(&zones, entry->player.id);
+  }
+  else
+  {
+    spatial_grid_remove(&player_grid, entry->player.id);
+  }
+  entry->player.x = 0;
+  entry->player.y = 0;
+  player_map_free(map, entry);
+}
+
+// Get a player by their ENetPeer*
+Player *get_player(ServerPlayerMap *map, ENetPeer *peer)
+{
+  PeerPlayerEntry *entry = player_map_from_peer(map, peer);
+  if (!entry)
+  {
+    LOG_DEBUG("No player found for peer");
+    return NULL;
+  }
+  return &entry->player;
+}
+
+// A player near the viewer, for picking who fits in a crowded snapshot
+typedef struct {
+  int distance; // Squared
+  int id;
+} NearbyPlayer;
+
+// Room to gather one client's visible players, sized to --max-players.
+// Each thread that builds snapshots has its own.
+typedef struct {
+  int *visible;
+  NearbyPlayer *others;
+} SnapshotScratch;
+
+// [0] for the main thread, [1 + zone index] for each zone worker
+SnapshotScratch *snapshot_scratch;
+int snapshot_scratch_count;
+
+static bool nearer(const NearbyPlayer *a, const NearbyPlayer *b)
+{
+  return a->distance < b->distance || (a->distance == b->distance && a->id < b->id);
+}
+
+// Reorder players so the keep nearest come first, in no particular order
+static void keep_nearest(NearbyPlayer *players, int count, int keep)
+{
+  int low = 0;
+  int high = count - 1;
+  while (low < high)
+  {
+    NearbyPlayer pivot = players[low + (high - low) / 2];
+    int i = low;
+    int j = high;
+    while (i <= j)
     {
-      map->entries[i].player.active = false;
-      map->entries[i].player.x = 0;
-      map->entries[i].player.y = 0;
-      map->entries[i].player.id = -1; // Reset player ID
-      PlayerIdPacket pkt;
-      pkt.type = PKT_REMOVE_PLAYER;
-      pkt.player_id = map->entries[i].player.id;
-      ENetPacket *epkt = enet_packet_create(
-          &pkt, sizeof(pkt), ENET_PACKET_FLAG_RELIABLE);
-      enet_host_broadcast(server, 0, epkt);
-      // Remove entry from map
-      for (int j = i; j < map->count - 1; j++)
+      while (nearer(&players[i], &pivot))
       {
-        map->entries[j] = map->entries[j + 1];
+        i++;
+      }
+      while (nearer(&pivot, &players[j]))
+      {
+        j--;
+      }
+      if (i <= j)
+      {
+        NearbyPlayer swap = players[i];
+        players[i++] = players[j];
+        players[j--] = swap;
       }
-      map->count--;
-      break;
+    }
+    if (keep - 1 <= j)
+    {
+      high = j;
+    }
+    else if (keep - 1 >= i)
+    {
+      low = i;
+    }
+    else
+    {
+      return;
     }
   }
 }
 
-// Get a player by their ENetPeer*
-Player *get_player(ServerPlayerMap *map, ENetPeer *peer)
+// Build the world state a client should see this tick: the viewer and every
+// player inside its area of interest. A crowd too large for one snapshot is
+// cut down to the players nearest the viewer. Players entering or leaving
+// show up as added or removed entities in the delta.
+static void build_client_snapshot(const SpatialGrid *grid, const Player *viewer,
+                                  SnapshotScratch *scratch, Snapshot *snapshot, uint32_t tick)
 {
-  printf("Looking up player for peer\n");
-  for (int i = 0; i < map->count; i++)
+  int *visible = scratch->visible;
+  int count = spatial_grid_query_radius(grid, viewer->x, viewer->y,
+                                        server_config.aoi_radius, visible,
+                                        server_config.max_players);
+
+  // The viewer always comes first: prediction is corrected from its entry
+  snapshot_clear(snapshot, tick);
+  snapshot_add_entity(snapshot, viewer->id, grid->pos_x[viewer->id], grid->pos_y[viewer->id]);
+
+  NearbyPlayer *others = scratch->others;
+  int other_count = 0;
+  for (int i = 0; i < count; i++)
   {
-    if (map->entries[i].peer == peer && map->entries[i].player.active)
+    int id = visible[i];
+    if (id == viewer->id)
     {
-      printf("Found player %d for peer\n", map->entries[i].player.id);
-      return &map->entries[i].player;
+      continue;
     }
+    int dx = grid->pos_x[id] - viewer->x;
+    int dy = grid->pos_y[id] - viewer->y;
+    others[other_count].distance = dx * dx + dy * dy;
+    others[other_count].id = id;
+    other_count++;
+  }
+  int room = SNAPSHOT_MAX_ENTITIES - 1;
+  if (other_count > room)
+  {
+    keep_nearest(others, other_count, room);
+    other_count = room;
+  }
+  for (int i = 0; i < other_count; i++)
+  {
+    int id = others[i].id;
+    snapshot_add_entity(snapshot, id, grid->pos_x[id], grid->pos_y[id]);
   }
-  printf("No player found for peer\n");
-  return NULL;
+  snapshot_sort(snapshot);
 }
 
-// Broadcast player positions to all connected clients
-void broadcast_player_positions(ServerPlayerMap *map)
+// Encode the changes since the last snapshot a client acknowledged.
+// Returns false when the client is up to date and nothing needs sending.
+// Only touches the client's own state, so zone workers can run it in parallel.
+static bool write_client_snapshot(const SpatialGrid *grid, PeerPlayerEntry *entry,
+                                  SnapshotScratch *scratch, uint32_t tick, WireWriter *w)
 {
-  PlayerPositionsPacket pkt;
-  pkt.type = PKT_PLAYER_POSITIONS;
-  pkt.player_count = 0;
-  // Fill the packet with active player positions
-  for (int i = 0; i < map->count; i++)
+  Snapshot current;
+  SnapshotHistory *history = &client_snapshots[entry->player.id];
+  InputBuffer *inputs = &client_inputs[entry->player.id];
+
+  build_client_snapshot(grid, &entry->player, scratch, &current, tick);
+
+  // Fall back to a full snapshot if the acked baseline is too old to delta against
+  const Snapshot *baseline = NULL;
+  if (tick - history->acked_sequence < SNAPSHOT_HISTORY)
   {
-    if (map->entries[i].player.active)
-    {
-      pkt.players[pkt.player_count].id = map->entries[i].player.id;
-      pkt.players[pkt.player_count].x = map->entries[i].player.x;
-      pkt.players[pkt.player_count].y = map->entries[i].player.y;
-      pkt.player_count++;
+    baseline = snapshot_history_find(history, history->acked_sequence);
+  }
 
-      printf("Player %d position: (%d, %d) color: %d\n", map->entries[i].player.id,
-             map->entries[i].player.x, map->entries[i].player.y, map->entries[i].player.color_index);
+  // The input ack lets the client drop confirmed inputs and replay the rest
+  int changes = snapshot_write_packet(w, baseline, &current, inputs->last_applied);
 
-      printf("Broadcasting player positions to all clients. Player count: %d\n",
-             pkt.player_count);
-    }
+  // Nothing changed, no input was processed and nothing is in flight: the
+  // client is already up to date. An empty snapshot still goes out now and
+  // then in case the last one it acked was not the newest. The first
+  // snapshot after movement is always sent so clients see entities stop
+  // instead of extrapolating them further.
+  if (changes == 0 && baseline && history->last_sequence == history->acked_sequence &&
+      inputs->last_applied == inputs->last_reported &&
+      last_snapshot_changes[entry->player.id] == 0 &&
+      tick - history->last_sequence < SNAPSHOT_KEEPALIVE_TICKS)
+  {
+    return false;
   }
 
-  // Create the packet for all player
-  ENetPacket *epkt = enet_packet_create(
-      &pkt, sizeof(unsigned char) * 2 + sizeof(struct {
-                                          unsigned char id, x, y;
-                                        }) * pkt.player_count,
-      ENET_PACKET_FLAG_RELIABLE);
-  // Broadcast to all connected peers
-  enet_host_broadcast(server, 1, epkt);
-  printf("Player positions broadcast complete\n");
+  snapshot_history_store(history, &current);
+  inputs->last_reported = inputs->last_applied;
+  last_snapshot_changes[entry->player.id] = changes;
+  return true;
 }
 
-// Load map from a text file
-bool load_map_from_file(const char *filename)
+// Zone worker: encode snapshots for the players the zone owns
+static void build_zone_snapshots(ZoneSet *set, Zone *zone, void *context)
 {
-  FILE *file = fopen(filename, "r");
-  if (!file)
+  uint32_t tick = *(const uint32_t *)context;
+  for (int i = 0; i < zone->owned_count; i++)
   {
-    printf("Failed to open map file: %s\n", filename);
-    return false;
+    int id = zone->owned[i];
+    zone_packets[id] = packet_pool_acquire(SNAPSHOT_MAX_PACKET_SIZE);
+    if (!zone_packets[id])
+    {
+      continue;
+    }
+    WireWriter w;
+    wire_writer_init(&w, zone_packets[id], SNAPSHOT_MAX_PACKET_SIZE);
+    if (!write_client_snapshot(&zone->grid, &set->map->entries[id],
+                               &snapshot_scratch[1 + zone->index], tick, &w))
+    {
+      packet_pool_release(zone_packets[id]);
+      zone_packets[id] = NULL;
+      continue;
+    }
+    zone_packet_sizes[id] = w.size;
   }
+}
 
-  char line[256];
-  int y = 0;
-
-  // Read the file line by line
-  while (fgets(line, sizeof(line), file) && y < VIEWPORT_HEIGHT)
+// Send each client the changes since the last snapshot it acknowledged
+void broadcast_snapshots(ServerPlayerMap *map, uint32_t tick)
+{
+  if (zones.count > 0)
   {
-    int x = 0;
-    char *token = strtok(line, " \t\n");
+    uint64_t build_started = tick_clock_us();
+    zone_set_run(&zones, build_zone_snapshots, &tick);
+    uint64_t build_ended = tick_clock_us();
+    profiler_add(&profiler, PROFILE_SNAPSHOTS, build_ended - build_started);
 
-    // Parse each number in the line
-    while (token && x < VIEWPORT_WIDTH)
+    for (int i = 0; i < map->count; i++)
     {
-      int tile_value = atoi(token);
-      game_map[x][y].tile_id = tile_value;
-      game_map[x][y].walkable =
-          (tile_value == 1); // Only tiles with value 1 are walkable
-
-      // Debug output for the first few tiles
-      if (x < 3 && y < 3)
+      PeerPlayerEntry *entry = &map->entries[map->active[i]];
+      int id = entry->player.id;
+      if (zone_packets[id])
       {
-        printf("Loaded tile at (%d, %d): id=%d, walkable=%d\n", x, y,
-               game_map[x][y].tile_id, game_map[x][y].walkable);
+        send_packet(entry->peer, CHANNEL_STATE,
+                    packet_pool_wrap(zone_packets[id], zone_packet_sizes[id], 0));
+        zone_packets[id] = NULL;
       }
-      x++;
-      token = strtok(NULL, " \t\n");
     }
+    profiler_add(&profiler, PROFILE_SEND, tick_clock_us() - build_ended);
+    return;
+  }
+
+  for (int i = 0; i < map->count; i++)
+  {
+    PeerPlayerEntry *entry = &map->entries[map->active[i]];
+
+    uint64_t build_started = tick_clock_us();
+    uint8_t *buffer = packet_pool_acquire(SNAPSHOT_MAX_PACKET_SIZE);
+    if (!buffer)
+    {
+      continue;
+    }
+    WireWriter w;
+    wire_writer_init(&w, buffer, SNAPSHOT_MAX_PACKET_SIZE);
+    bool send = write_client_snapshot(&player_grid, entry, &snapshot_scratch[0], tick, &w);
+    uint64_t build_ended = tick_clock_us();
+    profiler_add(&profiler, PROFILE_SNAPSHOTS, build_ended - build_started);
+    if (!send)
+    {
+      packet_pool_release(buffer);
+      continue;
+    }
+
+    // Unreliable and sequenced: a lost snapshot is superseded by the next one
+    ENetPacket *epkt = packet_pool_wrap(buffer, w.size, 0);
+    send_packet(entry->peer, CHANNEL_STATE, epkt);
+    profiler_add(&profiler, PROFILE_SEND, tick_clock_us() - build_ended);
+  }
+}
+
+// Record the newest snapshot a client has received
+void process_snapshot_ack(ENetPeer *peer, const SnapshotAckPacket *pkt)
+{
+  Player *player = get_player(&player_map, peer);
+  if (!player)
+  {
+    return;
+  }
+
+  SnapshotHistory *history = &client_snapshots[player->id];
+  // Acks can arrive late or for snapshots we never sent; only move forward
+  if (pkt->sequence > history->acked_sequence && pkt->sequence <= history->last_sequence)
+  {
+    history->acked_sequence = pkt->sequence;
+  }
+}
 
-    y++;
+// Load the map, either a binary map file or a text map
+bool load_map_from_file(const char *filename)
+{
+  if (map_file_is_binary(filename))
+  {
+    if (!map_load_binary(&world, filename))
+    {
+      return false;
+    }
+    // Skip the walkable summary: it would page in the whole file
+    LOG_INFO("Mapped %s: %dx%d tiles in %d chunks", filename, world.width,
+             world.height, world.allocated);
+    return true;
+  }
+
+  if (!map_load_text(&world, filename))
+  {
+    return false;
   }
 
-  fclose(file);
-  printf("Map loaded successfully from %s\n", filename);
+  LOG_INFO("Map loaded successfully from %s", filename);
 
   // Print a summary of the map
   int walkable_count = 0;
-  int total_tiles = VIEWPORT_WIDTH * VIEWPORT_HEIGHT;
+  int total_tiles = world.width * world.height;
 
-  for (int y = 0; y < VIEWPORT_HEIGHT; y++)
+  for (int y = 0; y < world.height; y++)
   {
-    for (int x = 0; x < VIEWPORT_WIDTH; x++)
+    for (int x = 0; x < world.width; x++)
     {
-      if (game_map[x][y].walkable)
+      if (world_is_walkable(&world, x, y))
       {
         walkable_count++;
       }
     }
   }
 
-  printf("Map summary: %d/%d tiles are walkable (%.1f%%)\n", walkable_count,
-         total_tiles, (float)walkable_count / total_tiles * 100);
+  LOG_INFO("Map summary: %dx%d tiles in %d chunks, %d/%d tiles are walkable (%.1f%%)",
+           world.width, world.height, world.allocated, walkable_count,
+           total_tiles, (float)walkable_count / total_tiles * 100);
 
   return true;
 }
@@ -191,185 +458,445 @@ void init_server(ServerPlayerMap *map)
 {
   if (enet_initialize() != 0)
   {
-    printf("Failed to initialize ENet\n");
+    LOG_ERROR("Failed to initialize ENet");
+    exit(EXIT_FAILURE);
+  }
+
+  // Create the server; a replay runs without one
+  if (!server_config.replay_file)
+  {
+    address.host = ENET_HOST_ANY;
+    address.port = 8081;
+    server = enet_host_create(&address, server_config.max_players, CHANNEL_COUNT, 0, 0);
+
+    if (server == NULL)
+    {
+      LOG_ERROR("Failed to create ENet server");
+      exit(EXIT_FAILURE);
+    }
+
+    LOG_INFO("Server created successfully");
+  }
+  if (!net_init(server, server_config.net_thread))
+  {
     exit(EXIT_FAILURE);
   }
 
-  // Create the server
-  address.host = ENET_HOST_ANY;
-  address.port = 8081;
-  server = enet_host_create(&address, 32, 2, 0, 0);
+  int capacity = server_config.max_players;
+  if (!player_map_init(map, capacity) ||
+      !spatial_grid_init(&player_grid, world.width, world.height, GRID_CELL_SIZE, capacity) ||
+      !tile_edits_init(&tile_edits, &world))
+  {
+    exit(EXIT_FAILURE);
+  }
 
-  if (server == NULL)
+  client_snapshots = calloc(capacity, sizeof(SnapshotHistory));
+  client_streams = calloc(capacity, sizeof(ChunkStream));
+  client_inputs = calloc(capacity, sizeof(InputBuffer));
+  last_snapshot_changes = calloc(capacity, sizeof(int));
+  if (!client_snapshots || !client_streams || !client_inputs || !last_snapshot_changes)
   {
-    printf("Failed to create ENet server\n");
+    LOG_ERROR("Failed to allocate client state for %d players", capacity);
     exit(EXIT_FAILURE);
   }
+  LOG_INFO("Room for %d players", capacity);
 
-  printf("Server created successfully\n");
+  // The ghost margin matches the area of interest so border queries are exact
+  if (!zone_set_init(&zones, server_config.zones, world.width, world.height,
+                     server_config.aoi_radius, map))
+  {
+    exit(EXIT_FAILURE);
+  }
+  if (zones.count > 0)
+  {
+    zone_packets = calloc(capacity, sizeof(*zone_packets));
+    zone_packet_sizes = calloc(capacity, sizeof(size_t));
+    if (!zone_packets || !zone_packet_sizes)
+    {
+      LOG_ERROR("Failed to allocate zone packet buffers");
+      exit(EXIT_FAILURE);
+    }
+  }
+  snapshot_scratch_count = 1 + zones.count;
+  snapshot_scratch = calloc(snapshot_scratch_count, sizeof(SnapshotScratch));
+  if (!snapshot_scratch)
+  {
+    LOG_ERROR("Failed to allocate snapshot scratch space");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < snapshot_scratch_count; i++)
+  {
+    snapshot_scratch[i].visible = malloc(capacity * sizeof(int));
+    snapshot_scratch[i].others = malloc(capacity * sizeof(NearbyPlayer));
+    if (!snapshot_scratch[i].visible || !snapshot_scratch[i].others)
+    {
+      LOG_ERROR("Failed to allocate snapshot scratch space for %d players", capacity);
+      exit(EXIT_FAILURE);
+    }
+  }
 
-  // Initialize player map
-  map->count = 0;
-  for (int i = 0; i < MAX_PLAYERS; i++)
+  // Enemies only chase players inside the area of interest, which zone
+  // grids answer exactly
+  if (!enemies_init(server_config.enemies, server_config.aoi_radius))
   {
-    map->entries[i].player.active = false;
-    map->entries[i].player.id = -1;
+    exit(EXIT_FAILURE);
   }
 }
 
-// Broadcast game state to all connected clients
-void broadcast_game_state(void)
+// Change a tile and queue it for the next tick's tile deltas; false if
+// nothing changed. Edits are recorded so a replay makes them at the same point.
+static bool edit_tile(int x, int y, unsigned char tile_id)
 {
-  for (int i = 0; i < player_map.count; i++)
+  if (!tile_edits_set(&tile_edits, &world, x, y, tile_id))
+  {
+    return false;
+  }
+  replay_record_tile(scheduler.tick, x, y, tile_id);
+  return true;
+}
+
+// Change one tile at runtime, e.g. terrain destroyed or built by a player.
+// Call between ticks or from the main thread during one.
+bool server_set_tile(int x, int y, unsigned char tile_id)
+{
+  if (!edit_tile(x, y, tile_id))
   {
-    if (player_map.entries[i].player.active)
+    return false;
+  }
+  enemies_tile_changed(x, y);
+  return true;
+}
+
+// Load the map file again and apply whatever differs from the running map as
+// tile edits, so clients pick up the changes without reconnecting. The map
+// must keep its size; players and enemies stay where they are.
+bool reload_map(const char *filename)
+{
+  World fresh = {0};
+  bool loaded = map_file_is_binary(filename) ? map_load_binary(&fresh, filename)
+                                             : map_load_text(&fresh, filename);
+  if (!loaded)
+  {
+    LOG_ERROR("Failed to reload %s; keeping the running map", filename);
+    return false;
+  }
+  if (fresh.width != world.width || fresh.height != world.height)
+  {
+    LOG_ERROR("Reloaded %s is %dx%d but the running map is %dx%d; keeping the running map",
+              filename, fresh.width, fresh.height, world.width, world.height);
+    map_unload(&fresh);
+    return false;
+  }
+
+  int changed_tiles = 0;
+  int changed_chunks = 0;
+  for (int chunk_y = 0; chunk_y < world.chunks_y; chunk_y++)
+  {
+    for (int chunk_x = 0; chunk_x < world.chunks_x; chunk_x++)
     {
-      // Send tile chunks to the player
-      send_tile_chunk(player_map.entries[i].peer, player_map.entries[i].player.x, player_map.entries[i].player.y);
+      const WorldChunk *old_chunk = world_get_chunk(&world, chunk_x, chunk_y);
+      const WorldChunk *new_chunk = world_get_chunk(&fresh, chunk_x, chunk_y);
+      if (old_chunk == new_chunk ||
+          (old_chunk && new_chunk && memcmp(old_chunk, new_chunk, sizeof(WorldChunk)) == 0))
+      {
+        continue;
+      }
+      int before = changed_tiles;
+      for (int y = chunk_y * CHUNK_SIZE; y < (chunk_y + 1) * CHUNK_SIZE && y < world.height; y++)
+      {
+        for (int x = chunk_x * CHUNK_SIZE; x < (chunk_x + 1) * CHUNK_SIZE && x < world.width; x++)
+        {
+          if (edit_tile(x, y, world_get_tile(&fresh, x, y).tile_id))
+          {
+            changed_tiles++;
+          }
+        }
+      }
+      changed_chunks += changed_tiles > before;
     }
   }
+  map_unload(&fresh);
+
+  // Cheaper to rebuild paths on demand than to repair them tile by tile
+  if (changed_tiles > 0)
+  {
+    enemies_reset_paths();
+  }
+  LOG_INFO("Reloaded %s: %d tiles changed in %d chunks", filename, changed_tiles, changed_chunks);
+  return true;
 }
 
-// Process server events
-void process_events(void)
+// Send the tiles changed since the last tick to every client that has their
+// chunk loaded. A chunk with only a few changes goes out as a delta; one
+// that mostly changed is sent whole.
+void broadcast_tile_edits(ServerPlayerMap *map)
 {
-  while (enet_host_service(server, &event, 0) > 0)
+  TileChange changes[CHUNK_TILE_COUNT];
+  unsigned char buffer[TILE_DELTA_MAX_PACKET_SIZE];
+
+  for (int i = 0; i < tile_edits.dirty_count; i++)
   {
-    switch (event.type)
+    const ChunkEdits *chunk = &tile_edits.dirty[i];
+    int count = tile_edits_changes(chunk, changes);
+    uint32_t version = tile_edits_version(&tile_edits, chunk->chunk_x, chunk->chunk_y);
+    WireWriter w;
+    wire_writer_init(&w, buffer, sizeof(buffer));
+    tile_delta_write_packet(&w, chunk->chunk_x, chunk->chunk_y, version, changes, count);
+
+    for (int j = 0; j < map->count; j++)
     {
-    case ENET_EVENT_TYPE_CONNECT:
-      handle_client_connection(&event);
-      break;
-    case ENET_EVENT_TYPE_DISCONNECT:
-      handle_client_disconnect(&event);
-      break;
-    case ENET_EVENT_TYPE_RECEIVE:
-      handle_client_packet(&event);
-      break;
-    default:
-      break;
+      PeerPlayerEntry *entry = &map->entries[map->active[j]];
+      if (!chunk_stream_has(&client_streams[entry->player.id], chunk->chunk_x, chunk->chunk_y))
+      {
+        continue;
+      }
+      if (count > TILE_DELTA_MAX_CHANGES)
+      {
+        send_tile_chunk(entry->peer, chunk->chunk_x, chunk->chunk_y);
+      }
+      else
+      {
+        send_packet(entry->peer, CHANNEL_RELIABLE,
+                    packet_pool_create(w.data, w.size, ENET_PACKET_FLAG_RELIABLE));
+      }
     }
   }
+  tile_edits_clear(&tile_edits);
 }
 
-// Broadcast old players to a new player
-void broadcast_old_players(ENetPeer *new_player)
+// Stream map chunks around each player and unload the ones left behind
+void stream_world_chunks(ServerPlayerMap *map)
 {
-  printf("Broadcasting old players to new player\n");
-  for (int i = 0; i < MAX_PLAYERS; i++)
+  for (int i = 0; i < map->count; i++)
   {
-    if (player_map.entries[i].player.active)
+    PeerPlayerEntry *entry = &map->entries[map->active[i]];
+    chunk_stream_update(&client_streams[entry->player.id], &world, entry->peer,
+                        entry->player.x, entry->player.y);
+  }
+}
+
+// Dispatch a single ENet event to its handler
+void dispatch_event(ENetEvent *event)
+{
+  uint64_t started = tick_clock_us();
+  switch (event->type)
+  {
+  case ENET_EVENT_TYPE_CONNECT:
+    handle_client_connection(event);
+    break;
+  case ENET_EVENT_TYPE_DISCONNECT:
+    handle_client_disconnect(event);
+    break;
+  case ENET_EVENT_TYPE_RECEIVE:
+    handle_client_packet(event);
+    break;
+  default:
+    break;
+  }
+  profiler_add(&profiler, PROFILE_EVENTS, tick_clock_us() - started);
+}
+
+// Process server events, blocking in ENet until the deadline is reached
+void process_events(enet_uint32 deadline)
+{
+  enet_uint32 now;
+  while (ENET_TIME_LESS(now = enet_time_get(), deadline))
+  {
+    if (net_poll(&event, deadline - now))
     {
-      PlayerIdPacket add_packet = {
-          PKT_ADD_PLAYER,
-          player_map.entries[i].player.id,
-          player_map.entries[i].player.color_index,
-      };
-      enet_peer_send(new_player, 0, enet_packet_create(&add_packet, sizeof(add_packet), ENET_PACKET_FLAG_RELIABLE));
-      printf("Sent PKT_ADD_PLAYER for player %d to new player\n", player_map.entries[i].player.id);
+      dispatch_event(&event);
     }
   }
+
+  // Drain anything that is already queued without waiting again
+  while (net_poll(&event, 0))
+  {
+    dispatch_event(&event);
+  }
 }
 
-// Handle client connection
-void handle_client_connection(ENetEvent *event)
+// Zone worker: replace the border ghosts with where players are now
+static void refresh_zone_ghosts(ZoneSet *set, Zone *zone, void *context)
 {
-  printf("New client connected\n");
+  (void)context;
+  zone_refresh_ghosts(set, zone);
+}
 
-  // Find an available player slot
-  int player_id = -1;
-  for (int i = 0; i < MAX_PLAYERS; i++)
+// Zone worker: apply one buffered input command per owned player. Moves only
+// touch the player and the zone's own grid; players that left the zone are
+// handed off afterwards.
+static void simulate_zone(ZoneSet *set, Zone *zone, void *context)
+{
+  (void)context;
+  for (int i = 0; i < zone->owned_count; i++)
   {
-    if (!player_map.entries[i].player.active)
+    PeerPlayerEntry *entry = &set->map->entries[zone->owned[i]];
+    InputCommand command;
+    if (input_buffer_pop(&client_inputs[entry->player.id], &command))
     {
-      player_id = i;
-      break;
+      process_move(&zone->grid, entry, &command);
     }
   }
+}
+
+// Grid holding the players near a tile column
+static const SpatialGrid *player_grid_at(int x)
+{
+  return zones.count > 0 ? zone_set_grid_at(&zones, x) : &player_grid;
+}
+
+// Run one fixed simulation step and send the resulting snapshot
+void server_tick(ServerPlayerMap *map, uint32_t tick)
+{
+  // Input is only buffered as it arrives; it takes effect here, at a fixed rate
+  uint64_t started = tick_clock_us();
+  if (zones.count > 0)
+  {
+    zone_set_run(&zones, simulate_zone, NULL);
+    zone_set_handoff(&zones);
+    // Ghosts are current before enemies and snapshots look at them, so a
+    // zone grid answers exactly like the single player grid would
+    zone_set_run(&zones, refresh_zone_ghosts, NULL);
+  }
+  else
+  {
+    apply_player_inputs(map);
+  }
+  uint64_t simulated = tick_clock_us();
+  profiler_add(&profiler, PROFILE_SIMULATION, simulated - started);
+  // Enemies react to where the players ended up this tick
+  enemies_update(map, player_grid_at, 1.0f / server_config.tick_rate);
+  uint64_t thought = tick_clock_us();
+  profiler_add(&profiler, PROFILE_AI, thought - simulated);
+  broadcast_tile_edits(map);
+  stream_world_chunks(map);
+  profiler_add(&profiler, PROFILE_CHUNKS, tick_clock_us() - thought);
+  broadcast_snapshots(map, tick);
+
+  // Put this tick's packets on the wire now instead of at the next service call
+  uint64_t flush_started = tick_clock_us();
+  net_flush();
+  profiler_add(&profiler, PROFILE_SEND, tick_clock_us() - flush_started);
+}
+
+// Broadcast old players to a new player
+void broadcast_old_players(ENetPeer *new_player)
+{
+  LOG_DEBUG("Broadcasting old players to new player");
+  for (int i = 0; i < player_map.count; i++)
+  {
+    const Player *player = &player_map.entries[player_map.active[i]].player;
+    PlayerIdPacket add_packet = {
+        PKT_ADD_PLAYER,
+        player->color_index,
+        player->id,
+    };
+    send_packet(new_player, CHANNEL_RELIABLE, packet_pool_create(&add_packet, sizeof(add_packet), ENET_PACKET_FLAG_RELIABLE));
+    LOG_DEBUG("Sent PKT_ADD_PLAYER for player %d to new player", player->id);
+  }
+}
+
+// Handle client connection
+void handle_client_connection(ENetEvent *event)
+{
+  LOG_INFO("New client connected");
 
-  if (player_id == -1)
+  // Take a free slot; the slot index is the player's id
+  PeerPlayerEntry *entry = player_map_alloc(&player_map, event->peer);
+  if (!entry)
   {
-    printf("No available player slots\n");
-    enet_peer_disconnect(event->peer, 0);
+    LOG_WARN("No available player slots");
+    net_disconnect(event->peer);
     return;
   }
+  int player_id = entry->player.id;
+  replay_record_connect(scheduler.tick, player_id);
 
   // Initialize the player
-  player_map.entries[player_id].player.active = true;
-  player_map.entries[player_id].peer = event->peer;
-  init_player(&player_map.entries[player_id].player, player_id);
+  init_player(&entry->player, player_id);
+  snapshot_history_reset(&client_snapshots[player_id]);
+  input_buffer_reset(&client_inputs[player_id]);
+  last_snapshot_changes[player_id] = 0;
+  if (zones.count > 0)
+  {
+    zone_set_add(&zones, player_id, entry->player.x, entry->player.y);
+  }
+  else
+  {
+    spatial_grid_insert(&player_grid, player_id, entry->player.x, entry->player.y);
+  }
 
   // Send the player their ID
-  PlayerIdPacket id_pkt;
+  WelcomePacket id_pkt;
   id_pkt.type = PKT_PLAYER_ID;
   id_pkt.player_id = player_id;
-  id_pkt.color_index = player_map.entries[player_id].player.color_index;
-  ENetPacket *epkt = enet_packet_create(&id_pkt, sizeof(id_pkt), ENET_PACKET_FLAG_RELIABLE);
-  enet_peer_send(event->peer, 0, epkt);
-  printf("Sent player ID %d to new client\n", player_id);
+  id_pkt.color_index = entry->player.color_index;
+  id_pkt.tick_rate = server_config.tick_rate;
+  id_pkt.max_players = server_config.max_players;
+  ENetPacket *epkt = packet_pool_create(&id_pkt, sizeof(id_pkt), ENET_PACKET_FLAG_RELIABLE);
+  send_packet(event->peer, CHANNEL_RELIABLE, epkt);
+  LOG_DEBUG("Sent player ID %d to new client", player_id);
 
-  // Send the entire map to the new player
-  printf("Sending entire map to new client\n");
-  for (int y = 0; y < VIEWPORT_HEIGHT / CHUNK_SIZE; y++)
-  {
-    for (int x = 0; x < VIEWPORT_WIDTH / CHUNK_SIZE; x++)
-    {
-      send_tile_chunk(event->peer, x, y);
-      printf("Sent tile chunk (%d, %d) to new client\n", x, y);
-    }
-  }
+  // The map around the player is streamed from the next tick on
+  chunk_stream_reset(&client_streams[player_id]);
 
   // Broadcast the new player to all other players
   PlayerIdPacket add_pkt;
   add_pkt.type = PKT_ADD_PLAYER;
   add_pkt.player_id = player_id;
-  add_pkt.color_index = player_map.entries[player_id].player.color_index;
-  epkt = enet_packet_create(&add_pkt, sizeof(add_pkt), ENET_PACKET_FLAG_RELIABLE);
-  enet_host_broadcast(server, 0, epkt);
-  printf("Broadcasted new player %d to all clients\n", player_id);
+  add_pkt.color_index = entry->player.color_index;
+  epkt = packet_pool_create(&add_pkt, sizeof(add_pkt), ENET_PACKET_FLAG_RELIABLE);
+  broadcast_packet(CHANNEL_RELIABLE, epkt);
+  LOG_DEBUG("Broadcasted new player %d to all clients", player_id);
 
   // Broadcast old players to the new player
-  printf("Broadcasting old players to new client\n");
+  LOG_DEBUG("Broadcasting old players to new client");
   broadcast_old_players(event->peer);
-  // Update player count
-  player_map.count++;
 }
 
-// Send a tile chunk to a client
+// Send a tile chunk to a client, compressed with the shared chunk codec
 void send_tile_chunk(ENetPeer *peer, int chunk_x, int chunk_y)
 {
-  TileChunkPacket pkt;
-  pkt.type = PKT_TILE_CHUNK;
-  pkt.chunk_x = chunk_x;
-  pkt.chunk_y = chunk_y;
+  unsigned char tile_ids[CHUNK_TILE_COUNT];
 
-  // Copy tiles from the game map to the packet
-  for (int y = 0; y < CHUNK_SIZE; y++)
+  // Only tile ids go on the wire; walkability comes from the tile table.
+  // Empty chunks are all void.
+  const WorldChunk *chunk = world_get_chunk(&world, chunk_x, chunk_y);
+  for (int i = 0; i < CHUNK_TILE_COUNT; i++)
   {
-    for (int x = 0; x < CHUNK_SIZE; x++)
-    {
-      int tile_x = chunk_x * CHUNK_SIZE + x;
-      int tile_y = chunk_y * CHUNK_SIZE + y;
-      if (tile_x >= 0 && tile_x < VIEWPORT_WIDTH && tile_y >= 0 && tile_y < VIEWPORT_HEIGHT)
-      {
-        pkt.tiles[y * CHUNK_SIZE + x] = game_map[tile_x][tile_y];
-      }
-      else
-      {
-        pkt.tiles[y * CHUNK_SIZE + x].tile_id = 0;
-        pkt.tiles[y * CHUNK_SIZE + x].walkable = false;
-      }
-    }
+    tile_ids[i] = chunk ? chunk->tiles[i].tile_id : TILE_VOID;
+  }
+
+  // Encoded straight into the buffer the packet is sent from
+  uint8_t *buffer = packet_pool_acquire(TILE_CHUNK_MAX_PACKET_SIZE);
+  if (!buffer)
+  {
+    return;
   }
+  WireWriter w;
+  wire_writer_init(&w, buffer, TILE_CHUNK_MAX_PACKET_SIZE);
+  tile_chunk_write_packet(&w, chunk_x, chunk_y, tile_edits_version(&tile_edits, chunk_x, chunk_y),
+                          tile_ids);
 
-  ENetPacket *epkt = enet_packet_create(&pkt, sizeof(pkt), ENET_PACKET_FLAG_RELIABLE);
-  enet_peer_send(peer, 0, epkt);
+  ENetPacket *epkt = packet_pool_wrap(buffer, w.size, ENET_PACKET_FLAG_RELIABLE);
+  send_packet(peer, CHANNEL_RELIABLE, epkt);
+}
+
+// Tell a client to drop a chunk it no longer needs
+void send_chunk_unload(ENetPeer *peer, int chunk_x, int chunk_y)
+{
+  ChunkUnloadPacket pkt;
+  pkt.type = PKT_UNLOAD_CHUNK;
+  pkt.chunk_x = chunk_x;
+  pkt.chunk_y = chunk_y;
+  ENetPacket *epkt = packet_pool_create(&pkt, sizeof(pkt), ENET_PACKET_FLAG_RELIABLE);
+  send_packet(peer, CHANNEL_RELIABLE, epkt);
 }
 
 // Handle client disconnect
 void handle_client_disconnect(ENetEvent *event)
 {
-  printf("Client disconnected\n");
+  LOG_INFO("Client disconnected");
   remove_player(&player_map, event->peer);
 }
 
@@ -379,114 +906,232 @@ void handle_client_packet(ENetEvent *event)
   unsigned char *data = event->packet->data;
   unsigned char type = data[0];
 
-  printf("Received packet type: %d\n", type);
+  LOG_TRACE("Received packet type: %d", type);
+  profiler_count_received(&profiler, type, event->packet->dataLength);
 
   switch (type)
   {
-  case PKT_MOVE:
-    printf("Processing PKT_MOVE packet\n");
-    process_move(event->peer, (MovePacket *)data);
+  case PKT_INPUT:
+    process_input(event->peer, data, event->packet->dataLength);
+    break;
+  case PKT_STATS_REQUEST:
+    process_stats_request(event->peer);
+    break;
+  case PKT_SNAPSHOT_ACK:
+    if (event->packet->dataLength >= sizeof(SnapshotAckPacket))
+    {
+      process_snapshot_ack(event->peer, (SnapshotAckPacket *)data);
+    }
+    break;
+  case PKT_CHUNK_REQUEST:
+    if (event->packet->dataLength >= sizeof(ChunkRequestPacket))
+    {
+      process_chunk_request(event->peer, (ChunkRequestPacket *)data);
+    }
     break;
   default:
-    printf("Unknown packet type: %d\n", type);
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 5, "Unknown packet type: %d", type);
     break;
   }
 
   enet_packet_destroy(event->packet);
 }
 
-// Process a move packet from a client
-void process_move(ENetPeer *peer, MovePacket *pkt)
+// Resend a chunk whose tile deltas a client could not apply. Only chunks the
+// client is meant to have loaded are sent.
+void process_chunk_request(ENetPeer *peer, const ChunkRequestPacket *pkt)
+{
+  PeerPlayerEntry *entry = player_map_from_peer(&player_map, peer);
+  if (!entry || !chunk_stream_has(&client_streams[entry->player.id], pkt->chunk_x, pkt->chunk_y))
+  {
+    return;
+  }
+  LOG_DEBUG("Resending chunk (%d, %d) to player %d", pkt->chunk_x, pkt->chunk_y,
+            entry->player.id);
+  send_tile_chunk(peer, pkt->chunk_x, pkt->chunk_y);
+}
+
+// Reply to a load tester asking how the server is keeping up
+void process_stats_request(ENetPeer *peer)
 {
-  printf("Processing move packet from client\n");
-  printf("Move packet contents - dir_x: %d, dir_y: %d\n", pkt->dir_x, pkt->dir_y);
+  TickPercentiles percentiles;
+  tick_percentiles(&scheduler, &percentiles);
+
+  ServerStats stats;
+  stats.tick = scheduler.tick;
+  stats.tick_rate = scheduler.tick_rate;
+  stats.players = player_map.count;
+  stats.overruns = scheduler.overruns;
+  stats.tick_samples = percentiles.samples;
+  stats.tick_p50_us = percentiles.p50_us;
+  stats.tick_p90_us = percentiles.p90_us;
+  stats.tick_p99_us = percentiles.p99_us;
+  stats.tick_max_us = percentiles.max_us;
 
+  uint8_t *buffer = packet_pool_acquire(SERVER_STATS_PACKET_SIZE);
+  if (!buffer)
+  {
+    return;
+  }
+  WireWriter w;
+  wire_writer_init(&w, buffer, SERVER_STATS_PACKET_SIZE);
+  server_stats_write_packet(&w, &stats);
+  send_packet(peer, CHANNEL_STATE, packet_pool_wrap(buffer, w.size, 0));
+}
+
+// Queue the commands in an input packet until the next tick
+void process_input(ENetPeer *peer, const unsigned char *data, size_t length)
+{
   Player *player = get_player(&player_map, peer);
   if (!player)
   {
-    printf("Move from unknown player\n");
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 5, "Input from unknown player");
     return;
   }
 
-  printf("Player %d current position: (%d, %d)\n", player->id, player->x, player->y);
+  InputCommand commands[INPUT_REDUNDANCY];
+  WireReader r;
+  wire_reader_init(&r, data, length);
+  int count = input_read_packet(&r, commands, INPUT_REDUNDANCY);
+  if (count < 0)
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 5, "Malformed input packet from player %d", player->id);
+    return;
+  }
+  queue_player_input(player->id, commands, count);
+}
 
-  // Calculate new position based on current position and direction
-  int new_x = player->x + pkt->dir_x;
-  int new_y = player->y + pkt->dir_y;
-  printf("Attempting to move to: (%d, %d)\n", new_x, new_y);
+// Buffer decoded commands for a player until the next tick. Everything the
+// simulation takes from clients passes through here, so this is where the
+// replay log picks it up.
+void queue_player_input(int player_id, const InputCommand *commands, int count)
+{
+  replay_record_input(scheduler.tick, player_id, commands, count);
+  input_buffer_push(&client_inputs[player_id], commands, count);
+}
 
-  // Check bounds
-  if (new_x < 0 || new_x >= VIEWPORT_WIDTH || new_y < 0 || new_y >= VIEWPORT_HEIGHT)
-  {
-    printf("Move out of bounds: (%d, %d) - Rejecting movement\n", new_x, new_y);
-    // Send current position back to client to correct invalid movement
-    PlayerPositionsPacket pos_pkt;
-    pos_pkt.type = PKT_PLAYER_POSITIONS;
-    pos_pkt.player_count = 1;
-    pos_pkt.players[player->id].id = player->id;
-    pos_pkt.players[player->id].x = player->x;
-    pos_pkt.players[player->id].y = player->y;
-    ENetPacket *epkt = enet_packet_create(&pos_pkt, sizeof(pos_pkt), ENET_PACKET_FLAG_RELIABLE);
-    if (enet_peer_send(peer, 0, epkt) < 0)
-    {
-      printf("Failed to send position correction packet\n");
-    }
-    else
-    {
-      printf("Sent position correction packet to player %d\n", player->id);
-    }
-    return;
+// Replays have no clients to acknowledge snapshots; pretend each one got
+// its newest so deltas stay as small as on a good connection
+void acknowledge_all_snapshots(ServerPlayerMap *map)
+{
+  for (int i = 0; i < map->count; i++)
+  {
+    SnapshotHistory *history = &client_snapshots[map->active[i]];
+    history->acked_sequence = history->last_sequence;
   }
+}
 
-  // Check if the new position is walkable
-  if (!game_map[new_x][new_y].walkable)
-  {
-    printf("Move to non-walkable tile: (%d, %d) - Rejecting movement\n", new_x, new_y);
-    // Send current position back to client to correct invalid movement
-    PlayerPositionsPacket pos_pkt;
-    pos_pkt.type = PKT_PLAYER_POSITIONS;
-    pos_pkt.player_count = 1;
-    pos_pkt.players[player->id].id = player->id;
-    pos_pkt.players[player->id].x = player->x;
-    pos_pkt.players[player->id].y = player->y;
-    ENetPacket *epkt = enet_packet_create(&pos_pkt, sizeof(pos_pkt), ENET_PACKET_FLAG_RELIABLE);
-    if (enet_peer_send(peer, 0, epkt) < 0)
+// Hash of the state the players' inputs decide: player and enemy positions.
+// A replay compares it with the recording to catch a changed outcome.
+uint64_t server_state_checksum(const ServerPlayerMap *map)
+{
+  uint64_t hash = 14695981039346656037ULL;
+#define MIX(value) hash = (hash ^ (uint32_t)(value)) * 1099511628211ULL
+  for (int id = 0; id < map->capacity; id++)
+  {
+    const Player *player = &map->entries[id].player;
+    if (player->active)
     {
-      printf("Failed to send position correction packet\n");
+      MIX(id);
+      MIX(player->x);
+      MIX(player->y);
     }
-    else
+  }
+  EntityPool *enemies = entity_pool(&entities, ENTITY_ENEMY);
+  for (int i = 0; enemies && i < enemies->count; i++)
+  {
+    MIX((int)enemies->x[i]);
+    MIX((int)enemies->y[i]);
+    MIX(enemies->owner[i]);
+  }
+#undef MIX
+  return hash;
+}
+
+// Apply one buffered input command per player
+void apply_player_inputs(ServerPlayerMap *map)
+{
+  for (int i = 0; i < map->count; i++)
+  {
+    PeerPlayerEntry *entry = &map->entries[map->active[i]];
+    InputCommand command;
+    if (input_buffer_pop(&client_inputs[entry->player.id], &command))
     {
-      printf("Sent position correction packet to player %d\n", player->id);
+      process_move(&player_grid, entry, &command);
     }
+  }
+}
+
+// Validate and apply one movement command. A rejected move needs no reply:
+// the client sees its input acknowledged in the next snapshot together with
+// the unchanged position and replays from there.
+void process_move(SpatialGrid *grid, PeerPlayerEntry *entry, const InputCommand *command)
+{
+  Player *player = &entry->player;
+  LOG_TRACE("Player %d input %u: dir_x: %d, dir_y: %d, position: (%d, %d)", player->id,
+            command->sequence, command->dir_x, command->dir_y, player->x, player->y);
+
+  // Calculate new position based on current position and direction
+  int new_x = player->x + command->dir_x;
+  int new_y = player->y + command->dir_y;
+  LOG_TRACE("Attempting to move to: (%d, %d)", new_x, new_y);
+
+  // Check bounds
+  if (!world_in_bounds(&world, new_x, new_y))
+  {
+    LOG_DEBUG("Move out of bounds: (%d, %d) - Rejecting movement", new_x, new_y);
     return;
   }
 
-  // Update player position in the player map
-  for (int i = 0; i < player_map.count; i++)
+  // Check if the new position is walkable
+  if (!world_is_walkable(&world, new_x, new_y))
   {
-    if (player_map.entries[i].player.id == player->id)
-    {
-      player_map.entries[i].player.x = new_x;
-      player_map.entries[i].player.y = new_y;
-      printf("Updated player %d position in map to (%d, %d)\n",
-             player->id, new_x, new_y);
-      break;
-    }
+    LOG_DEBUG("Move to non-walkable tile: (%d, %d) - Rejecting movement", new_x, new_y);
+    return;
   }
 
-  // Also update the player pointer for consistency
+  // The player points straight into the slot table
   player->x = new_x;
   player->y = new_y;
-  printf("Validated and applied movement for player %d to (%d, %d)\n",
-         player->id, new_x, new_y);
-
-  // Broadcast the new position to all clients
-  broadcast_player_positions(&player_map);
+  spatial_grid_move(grid, player->id, new_x, new_y);
+  LOG_TRACE("Validated and applied movement for player %d to (%d, %d)",
+            player->id, new_x, new_y);
 }
 
 // Cleanup server resources
 void cleanup_server(void)
 {
-  enet_host_destroy(server);
+  zone_set_shutdown(&zones);
+  enemies_shutdown();
+  spatial_grid_free(&player_grid);
+  player_map_destroy(&player_map);
+  free(client_snapshots);
+  free(client_streams);
+  free(client_inputs);
+  free(last_snapshot_changes);
+  if (zone_packets)
+  {
+    for (int i = 0; i < server_config.max_players; i++)
+    {
+      packet_pool_release(zone_packets[i]);
+    }
+  }
+  free(zone_packets);
+  free(zone_packet_sizes);
+  for (int i = 0; i < snapshot_scratch_count; i++)
+  {
+    free(snapshot_scratch[i].visible);
+    free(snapshot_scratch[i].others);
+  }
+  free(snapshot_scratch);
+  tile_edits_free(&tile_edits);
+  map_unload(&world);
+  net_shutdown();
+  if (server)
+  {
+    enet_host_destroy(server);
+  }
+  // After the host so buffers of packets still queued come back first
+  packet_pool_shutdown();
   enet_deinitialize();
 }
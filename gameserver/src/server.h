@@ -5,6 +5,18 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "../../common/src/common.h"
+#include "../../common/src/input.h"
+#include "../../common/src/snapshot.h"
+#include "player_map.h"
+#include "spatial_grid.h"
+
+// Send an empty snapshot at least this often so clients resync after lost input
+#define SNAPSHOT_KEEPALIVE_TICKS 20
+// Default radius in tiles around a player inside which other players are sent
+#define DEFAULT_AOI_RADIUS 16
+// Profiler report written every this many seconds, and where to
+#define DEFAULT_PROFILE_INTERVAL 60
+#define DEFAULT_PROFILE_FILE "server_profile.txt"
 
 // Server-specific structures
 typedef struct {
@@ -13,25 +25,48 @@ typedef struct {
   bool is_local;
 } ServerPlayer;
 
-// Use the common PeerPlayerEntry
+// Runtime server settings, filled from the command line
 typedef struct {
-  PeerPlayerEntry entries[MAX_PLAYERS];
-  int count;
-} ServerPlayerMap;
+  uint32_t tick_rate;
+  int aoi_radius;
+  const char *map_file; // Text map or binary map built by tools/mapconv
+  const char *profile_file;
+  int profile_interval;  // Seconds between profiler reports, 0 for on demand only
+  bool net_thread;       // Service ENet on its own thread
+  int zones;             // Worker threads splitting the world, 0 or 1 for none
+  int max_players;       // Player slots and ENet peers, fixed at startup
+  int enemies;           // Enemies spawned at startup
+  const char *record_file; // Replay log written while running, NULL for none
+  const char *replay_file; // Replay log to run instead of listening, NULL for none
+} ServerConfig;
 
 // Server-specific functions
 void init_server(ServerPlayerMap *map);
 void cleanup_server(void);
-void process_events(void);
-void broadcast_game_state(void);
-void broadcast_player_positions(ServerPlayerMap *map);
+void process_events(enet_uint32 deadline);
+void dispatch_event(ENetEvent *event);
+void server_tick(ServerPlayerMap *map, uint32_t tick);
+void stream_world_chunks(ServerPlayerMap *map);
+void broadcast_tile_edits(ServerPlayerMap *map);
+bool server_set_tile(int x, int y, unsigned char tile_id);
+bool reload_map(const char *filename);
+void broadcast_snapshots(ServerPlayerMap *map, uint32_t tick);
+void process_snapshot_ack(ENetPeer *peer, const SnapshotAckPacket *pkt);
 void remove_player(ServerPlayerMap *map, ENetPeer* peer);
 Player *get_player(ServerPlayerMap *map, ENetPeer* peer);
 void handle_client_connection(ENetEvent *event);
 void handle_client_disconnect(ENetEvent *event);
 void handle_client_packet(ENetEvent *event);
 void send_tile_chunk(ENetPeer *peer, int chunk_x, int chunk_y);
-void process_move(ENetPeer *peer, MovePacket *pkt);
+void send_chunk_unload(ENetPeer *peer, int chunk_x, int chunk_y);
+void process_stats_request(ENetPeer *peer);
+void process_chunk_request(ENetPeer *peer, const ChunkRequestPacket *pkt);
+void process_input(ENetPeer *peer, const unsigned char *data, size_t length);
+void queue_player_input(int player_id, const InputCommand *commands, int count);
+void acknowledge_all_snapshots(ServerPlayerMap *map);
+uint64_t server_state_checksum(const ServerPlayerMap *map);
+void apply_player_inputs(ServerPlayerMap *map);
+void process_move(SpatialGrid *grid, PeerPlayerEntry *entry, const InputCommand *command);
 void broadcast_old_players(ENetPeer *new_player);
 bool load_map_from_file(const char *filename);
 
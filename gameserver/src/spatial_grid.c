@@ -0,0 +1,197 @@
+#include "spatial_grid.h"
+#include "../../common/src/log.h"
+#include <stdlib.h>
+
+// Cell index for a tile position, clamped to the grid
+static int grid_cell_index(const SpatialGrid *grid, int x, int y)
+{
+  int cx = x / grid->cell_size;
+  int cy = y / grid->cell_size;
+  if (cx < 0) cx = 0;
+  if (cy < 0) cy = 0;
+  if (cx >= grid->width) cx = grid->width - 1;
+  if (cy >= grid->height) cy = grid->height - 1;
+  return cy * grid->width + cx;
+}
+
+static void grid_link(SpatialGrid *grid, int id, int cell)
+{
+  grid->cell_of[id] = cell;
+  grid->prev[id] = -1;
+  grid->next[id] = grid->cell_heads[cell];
+  if (grid->cell_heads[cell] != -1)
+  {
+    grid->prev[grid->cell_heads[cell]] = id;
+  }
+  grid->cell_heads[cell] = id;
+}
+
+static void grid_unlink(SpatialGrid *grid, int id)
+{
+  int cell = grid->cell_of[id];
+  if (grid->prev[id] != -1)
+  {
+    grid->next[grid->prev[id]] = grid->next[id];
+  }
+  else
+  {
+    grid->cell_heads[cell] = grid->next[id];
+  }
+  if (grid->next[id] != -1)
+  {
+    grid->prev[grid->next[id]] = grid->prev[id];
+  }
+  grid->cell_of[id] = -1;
+}
+
+// Allocate a grid covering a world of the given size in tiles
+bool spatial_grid_init(SpatialGrid *grid, int world_width, int world_height,
+                       int cell_size, int capacity)
+{
+  grid->cell_size = cell_size;
+  grid->width = (world_width + cell_size - 1) / cell_size;
+  grid->height = (world_height + cell_size - 1) / cell_size;
+  if (grid->width < 1) grid->width = 1;
+  if (grid->height < 1) grid->height = 1;
+  grid->capacity = capacity;
+
+  grid->cell_heads = malloc(sizeof(int) * grid->width * grid->height);
+  grid->next = malloc(sizeof(int) * capacity);
+  grid->prev = malloc(sizeof(int) * capacity);
+  grid->cell_of = malloc(sizeof(int) * capacity);
+  grid->pos_x = calloc(capacity, sizeof(int));
+  grid->pos_y = calloc(capacity, sizeof(int));
+  if (!grid->cell_heads || !grid->next || !grid->prev || !grid->cell_of ||
+      !grid->pos_x || !grid->pos_y)
+  {
+    LOG_ERROR("Failed to allocate spatial grid");
+    spatial_grid_free(grid);
+    return false;
+  }
+
+  for (int i = 0; i < grid->width * grid->height; i++)
+  {
+    grid->cell_heads[i] = -1;
+  }
+  for (int i = 0; i < capacity; i++)
+  {
+    grid->next[i] = -1;
+    grid->prev[i] = -1;
+    grid->cell_of[i] = -1;
+  }
+  return true;
+}
+
+void spatial_grid_free(SpatialGrid *grid)
+{
+  free(grid->cell_heads);
+  free(grid->next);
+  free(grid->prev);
+  free(grid->cell_of);
+  free(grid->pos_x);
+  free(grid->pos_y);
+  grid->cell_heads = grid->next = grid->prev = grid->cell_of = NULL;
+  grid->pos_x = grid->pos_y = NULL;
+}
+
+void spatial_grid_insert(SpatialGrid *grid, int id, int x, int y)
+{
+  if (id < 0 || id >= grid->capacity)
+  {
+    return;
+  }
+  if (grid->cell_of[id] != -1)
+  {
+    grid_unlink(grid, id);
+  }
+  grid->pos_x[id] = x;
+  grid->pos_y[id] = y;
+  grid_link(grid, id, grid_cell_index(grid, x, y));
+}
+
+void spatial_grid_remove(SpatialGrid *grid, int id)
+{
+  if (id < 0 || id >= grid->capacity || grid->cell_of[id] == -1)
+  {
+    return;
+  }
+  grid_unlink(grid, id);
+}
+
+// Update an entity's position, relinking only when it changes cell
+void spatial_grid_move(SpatialGrid *grid, int id, int x, int y)
+{
+  if (!spatial_grid_contains(grid, id))
+  {
+    spatial_grid_insert(grid, id, x, y);
+    return;
+  }
+  grid->pos_x[id] = x;
+  grid->pos_y[id] = y;
+  int cell = grid_cell_index(grid, x, y);
+  if (cell != grid->cell_of[id])
+  {
+    grid_unlink(grid, id);
+    grid_link(grid, id, cell);
+  }
+}
+
+bool spatial_grid_contains(const SpatialGrid *grid, int id)
+{
+  return id >= 0 && id < grid->capacity && grid->cell_of[id] != -1;
+}
+
+// Walk the cells overlapping a tile rectangle and collect the entities inside it,
+// optionally also within radius_sq of a center point
+static int grid_query(const SpatialGrid *grid, int min_x, int min_y, int max_x, int max_y,
+                      int center_x, int center_y, int radius_sq, int *out, int max_out)
+{
+  int count = 0;
+  int first = grid_cell_index(grid, min_x, min_y);
+  int last = grid_cell_index(grid, max_x, max_y);
+  int first_cx = first % grid->width, first_cy = first / grid->width;
+  int last_cx = last % grid->width, last_cy = last / grid->width;
+
+  for (int cy = first_cy; cy <= last_cy; cy++)
+  {
+    for (int cx = first_cx; cx <= last_cx; cx++)
+    {
+      for (int id = grid->cell_heads[cy * grid->width + cx]; id != -1; id = grid->next[id])
+      {
+        int x = grid->pos_x[id];
+        int y = grid->pos_y[id];
+        if (x < min_x || x > max_x || y < min_y || y > max_y)
+        {
+          continue;
+        }
+        if (radius_sq >= 0 &&
+            (x - center_x) * (x - center_x) + (y - center_y) * (y - center_y) > radius_sq)
+        {
+          continue;
+        }
+        if (count == max_out)
+        {
+          return count;
+        }
+        out[count++] = id;
+      }
+    }
+  }
+  return count;
+}
+
+// Collect the entities inside an inclusive tile rectangle.
+// Returns the number of ids written to out.
+int spatial_grid_query_rect(const SpatialGrid *grid, int min_x, int min_y,
+                            int max_x, int max_y, int *out, int max_out)
+{
+  return grid_query(grid, min_x, min_y, max_x, max_y, 0, 0, -1, out, max_out);
+}
+
+// Collect the entities within a euclidean tile radius of a point
+int spatial_grid_query_radius(const SpatialGrid *grid, int center_x, int center_y,
+                              int radius, int *out, int max_out)
+{
+  return grid_query(grid, center_x - radius, center_y - radius, center_x + radius,
+                    center_y + radius, center_x, center_y, radius * radius, out, max_out);
+}
@@ -0,0 +1,36 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <stdbool.h>
+
+// Side of a grid cell in tiles
+#define GRID_CELL_SIZE 8
+
+// Uniform grid over the world that buckets entity ids by tile position.
+// Each cell holds an intrusive doubly linked list so moves and removals are O(1).
+typedef struct {
+  int width;        // Grid size in cells
+  int height;
+  int cell_size;    // Cell side in tiles
+  int capacity;     // Entity ids must be in [0, capacity)
+  int *cell_heads;  // First entity in each cell, -1 if empty
+  int *next;        // Next entity in the same cell, -1 at the end
+  int *prev;        // Previous entity in the same cell, -1 at the head
+  int *cell_of;     // Cell of each entity, -1 when not in the grid
+  int *pos_x;       // Tile position of each entity
+  int *pos_y;
+} SpatialGrid;
+
+bool spatial_grid_init(SpatialGrid *grid, int world_width, int world_height,
+                       int cell_size, int capacity);
+void spatial_grid_free(SpatialGrid *grid);
+void spatial_grid_insert(SpatialGrid *grid, int id, int x, int y);
+void spatial_grid_remove(SpatialGrid *grid, int id);
+void spatial_grid_move(SpatialGrid *grid, int id, int x, int y);
+bool spatial_grid_contains(const SpatialGrid *grid, int id);
+int spatial_grid_query_rect(const SpatialGrid *grid, int min_x, int min_y,
+                            int max_x, int max_y, int *out, int max_out);
+int spatial_grid_query_radius(const SpatialGrid *grid, int center_x, int center_y,
+                              int radius, int *out, int max_out);
+
+#endif // SPATIAL_GRID_H
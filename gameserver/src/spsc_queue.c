@@ -0,0 +1,59 @@
+#include "spsc_queue.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Capacity is rounded up to a power of two
+bool spsc_queue_init(SpscQueue *q, size_t capacity, size_t item_size)
+{
+  size_t size = 1;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+  q->slots = malloc(size * item_size);
+  if (!q->slots)
+  {
+    return false;
+  }
+  q->item_size = item_size;
+  q->mask = size - 1;
+  atomic_init(&q->head, 0);
+  atomic_init(&q->tail, 0);
+  return true;
+}
+
+void spsc_queue_free(SpscQueue *q)
+{
+  free(q->slots);
+  q->slots = NULL;
+}
+
+// Producer side; fails when the queue is full
+bool spsc_queue_push(SpscQueue *q, const void *item)
+{
+  size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+  if (tail - head > q->mask)
+  {
+    return false;
+  }
+  memcpy(q->slots + (tail & q->mask) * q->item_size, item, q->item_size);
+  // Publish the slot contents together with the new tail
+  atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+// Consumer side; fails when the queue is empty
+bool spsc_queue_pop(SpscQueue *q, void *item)
+{
+  size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+  if (head == tail)
+  {
+    return false;
+  }
+  memcpy(item, q->slots + (head & q->mask) * q->item_size, q->item_size);
+  // Hand the slot back to the producer only after it has been copied out
+  atomic_store_explicit(&q->head, head + 1, memory_order_release);
+  return true;
+}
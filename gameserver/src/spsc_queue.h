@@ -0,0 +1,25 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Items are copied in and out of fixed-size slots. head and tail sit
+// on separate cache lines so the two threads do not invalidate each other.
+typedef struct {
+  unsigned char *slots;
+  size_t item_size;
+  size_t mask; // Capacity - 1, capacity is a power of two
+  _Alignas(64) atomic_size_t head; // Next slot to read, written by the consumer
+  _Alignas(64) atomic_size_t tail; // Next slot to write, written by the producer
+} SpscQueue;
+
+bool spsc_queue_init(SpscQueue *q, size_t capacity, size_t item_size);
+void spsc_queue_free(SpscQueue *q);
+bool spsc_queue_push(SpscQueue *q, const void *item);
+bool spsc_queue_pop(SpscQueue *q, void *item);
+
+#endif // SPSC_QUEUE_H
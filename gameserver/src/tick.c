@@ -0,0 +1,141 @@
+#include "tick.h"
+#include "../../common/src/log.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Monotonic clock with microsecond resolution; enet_time_get() only has milliseconds
+uint64_t tick_clock_us(void)
+{
+#ifdef _WIN32
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (uint64_t)(counter.QuadPart * 1000000.0 / frequency.QuadPart);
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+// Deadline of a given tick, computed from the anchor so rounding never drifts
+static enet_uint32 tick_deadline(const TickScheduler *ts, uint32_t tick)
+{
+  uint64_t elapsed_ticks = tick - ts->start_tick;
+  return ts->start_time + (enet_uint32)(elapsed_ticks * 1000 / ts->tick_rate);
+}
+
+// Initialize the scheduler and anchor it at the current time
+void tick_init(TickScheduler *ts, uint32_t tick_rate)
+{
+  if (tick_rate == 0)
+  {
+    tick_rate = DEFAULT_TICK_RATE;
+  }
+  if (tick_rate > MAX_TICK_RATE)
+  {
+    tick_rate = MAX_TICK_RATE;
+  }
+
+  ts->tick_rate = tick_rate;
+  ts->start_time = enet_time_get();
+  ts->start_tick = 0;
+  ts->tick = 0;
+  ts->tick_started = ts->start_time;
+  ts->last_tick_ms = 0;
+  ts->max_tick_ms = 0;
+  ts->overruns = 0;
+  ts->skipped_ticks = 0;
+  ts->tick_started_us = 0;
+  ts->sample_count = 0;
+}
+
+// Time at which the next tick should start
+enet_uint32 tick_next_deadline(const TickScheduler *ts)
+{
+  return tick_deadline(ts, ts->tick + 1);
+}
+
+// Mark the start of a tick
+void tick_begin(TickScheduler *ts)
+{
+  ts->tick++;
+  ts->tick_started = enet_time_get();
+  ts->tick_started_us = tick_clock_us();
+}
+
+// Mark the end of a tick and account for overruns
+void tick_end(TickScheduler *ts)
+{
+  enet_uint32 now = enet_time_get();
+  enet_uint32 next_deadline = tick_next_deadline(ts);
+
+  ts->samples_us[ts->sample_count % TICK_SAMPLE_COUNT] =
+      (uint32_t)(tick_clock_us() - ts->tick_started_us);
+  ts->sample_count++;
+
+  ts->last_tick_ms = ENET_TIME_DIFFERENCE(now, ts->tick_started);
+  if (ts->last_tick_ms > ts->max_tick_ms)
+  {
+    ts->max_tick_ms = ts->last_tick_ms;
+  }
+
+  if (!ENET_TIME_GREATER(now, next_deadline))
+  {
+    return;
+  }
+
+  ts->overruns++;
+  uint32_t late_ms = ENET_TIME_DIFFERENCE(now, next_deadline);
+  uint32_t behind = (uint32_t)((uint64_t)late_ms * ts->tick_rate / 1000);
+  LOG_RATE_LIMITED(LOG_LEVEL_WARN, 5, "Tick %u overran by %u ms (took %u ms)",
+                   ts->tick, late_ms, ts->last_tick_ms);
+
+  // Too far behind to catch up: drop the missed ticks and re-anchor
+  if (behind >= MAX_CATCHUP_TICKS)
+  {
+    ts->skipped_ticks += behind;
+    ts->start_time = now;
+    ts->start_tick = ts->tick;
+    LOG_WARN("Server is %u ticks behind, skipping ahead", behind);
+  }
+}
+
+// Print a summary of the schedule
+void tick_print_stats(const TickScheduler *ts)
+{
+  LOG_INFO("Ticks: %u at %u Hz, overruns: %u, skipped: %u, longest tick: %u ms",
+           ts->tick, ts->tick_rate, ts->overruns, ts->skipped_ticks,
+           ts->max_tick_ms);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a;
+  uint32_t y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Percentiles of the most recent tick durations
+void tick_percentiles(const TickScheduler *ts, TickPercentiles *out)
+{
+  static uint32_t sorted[TICK_SAMPLE_COUNT];
+  uint32_t count = ts->sample_count < TICK_SAMPLE_COUNT ? ts->sample_count : TICK_SAMPLE_COUNT;
+
+  memset(out, 0, sizeof(*out));
+  out->samples = count;
+  if (count == 0)
+  {
+    return;
+  }
+  memcpy(sorted, ts->samples_us, count * sizeof(uint32_t));
+  qsort(sorted, count, sizeof(uint32_t), compare_u32);
+  out->p50_us = sorted[(count - 1) * 50 / 100];
+  out->p90_us = sorted[(count - 1) * 90 / 100];
+  out->p99_us = sorted[(count - 1) * 99 / 100];
+  out->max_us = sorted[count - 1];
+}
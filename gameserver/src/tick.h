@@ -0,0 +1,50 @@
+#ifndef TICK_H
+#define TICK_H
+
+#include <enet/enet.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Tick rate used when none is given on the command line
+#define DEFAULT_TICK_RATE 20
+#define MAX_TICK_RATE 1000
+// When the server falls this many ticks behind it drops them instead of
+// running a burst of catch-up ticks
+#define MAX_CATCHUP_TICKS 5
+// Recent tick durations kept for percentile reporting
+#define TICK_SAMPLE_COUNT 1024
+
+// Fixed-rate tick schedule driven by enet_time_get()
+typedef struct {
+  uint32_t tick_rate;
+  enet_uint32 start_time;     // Time the current schedule was anchored at
+  uint32_t start_tick;        // Tick number at start_time
+  uint32_t tick;              // Current tick number
+  enet_uint32 tick_started;   // Time the current tick began
+  uint32_t last_tick_ms;      // Duration of the last tick
+  uint32_t max_tick_ms;       // Longest tick seen so far
+  uint32_t overruns;          // Ticks that ended past the next deadline
+  uint32_t skipped_ticks;     // Ticks dropped to get back on schedule
+  uint64_t tick_started_us;   // Microsecond clock at the start of the tick
+  uint32_t samples_us[TICK_SAMPLE_COUNT]; // Ring of recent tick durations
+  uint32_t sample_count;      // Total ticks measured; the ring holds the newest
+} TickScheduler;
+
+// Tick duration percentiles over the sample ring, in microseconds
+typedef struct {
+  uint32_t samples;
+  uint32_t p50_us;
+  uint32_t p90_us;
+  uint32_t p99_us;
+  uint32_t max_us;
+} TickPercentiles;
+
+void tick_init(TickScheduler *ts, uint32_t tick_rate);
+enet_uint32 tick_next_deadline(const TickScheduler *ts);
+void tick_begin(TickScheduler *ts);
+void tick_end(TickScheduler *ts);
+void tick_print_stats(const TickScheduler *ts);
+void tick_percentiles(const TickScheduler *ts, TickPercentiles *out);
+uint64_t tick_clock_us(void);
+
+#endif // TICK_H
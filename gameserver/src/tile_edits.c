@@ -0,0 +1,123 @@
+#include "tile_edits.h"
+#include "../../common/src/log.h"
+#include "../../common/src/tiles.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool tile_edits_init(TileEdits *edits, const World *world)
+{
+  size_t chunk_count = (size_t)world->chunks_x * world->chunks_y;
+  edits->chunks_x = world->chunks_x;
+  edits->versions = calloc(chunk_count, sizeof(uint32_t));
+  edits->pending = malloc(chunk_count * sizeof(int));
+  edits->dirty = NULL;
+  edits->dirty_count = 0;
+  edits->dirty_capacity = 0;
+  if (!edits->versions || !edits->pending)
+  {
+    LOG_ERROR("Failed to allocate tile edit tables for %zu chunks", chunk_count);
+    tile_edits_free(edits);
+    return false;
+  }
+  for (size_t i = 0; i < chunk_count; i++)
+  {
+    edits->pending[i] = -1;
+  }
+  return true;
+}
+
+void tile_edits_free(TileEdits *edits)
+{
+  free(edits->versions);
+  free(edits->pending);
+  free(edits->dirty);
+  edits->versions = NULL;
+  edits->pending = NULL;
+  edits->dirty = NULL;
+  edits->dirty_count = edits->dirty_capacity = 0;
+}
+
+// Entry collecting this tick's edits to a chunk, NULL if out of memory
+static ChunkEdits *dirty_chunk(TileEdits *edits, int chunk_x, int chunk_y)
+{
+  int *pending = &edits->pending[chunk_y * edits->chunks_x + chunk_x];
+  if (*pending >= 0)
+  {
+    return &edits->dirty[*pending];
+  }
+  if (edits->dirty_count == edits->dirty_capacity)
+  {
+    int capacity = edits->dirty_capacity ? edits->dirty_capacity * 2 : 16;
+    ChunkEdits *dirty = realloc(edits->dirty, capacity * sizeof(ChunkEdits));
+    if (!dirty)
+    {
+      LOG_ERROR("Failed to grow the tile edit list to %d chunks", capacity);
+      return NULL;
+    }
+    edits->dirty = dirty;
+    edits->dirty_capacity = capacity;
+  }
+
+  ChunkEdits *chunk = &edits->dirty[edits->dirty_count];
+  *pending = edits->dirty_count++;
+  chunk->chunk_x = chunk_x;
+  chunk->chunk_y = chunk_y;
+  memset(chunk->changed, 0, sizeof(chunk->changed));
+  edits->versions[chunk_y * edits->chunks_x + chunk_x]++;
+  return chunk;
+}
+
+// Change one tile and remember it for the next broadcast. False if the tile
+// is outside the world, already has that id, or could not be stored.
+bool tile_edits_set(TileEdits *edits, World *world, int x, int y, unsigned char tile_id)
+{
+  if (!world_in_bounds(world, x, y) || world_get_tile(world, x, y).tile_id == tile_id)
+  {
+    return false;
+  }
+  ChunkEdits *chunk = dirty_chunk(edits, x / CHUNK_SIZE, y / CHUNK_SIZE);
+  if (!chunk || !world_set_tile(world, x, y, tile_from_id(tile_id)))
+  {
+    return false;
+  }
+  int index = (y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE;
+  chunk->changed[index / 64] |= 1ull << (index % 64);
+  chunk->tile_ids[index] = tile_id;
+  return true;
+}
+
+// Current version of a chunk; every chunk starts at 0 with the loaded map
+uint32_t tile_edits_version(const TileEdits *edits, int chunk_x, int chunk_y)
+{
+  return edits->versions[chunk_y * edits->chunks_x + chunk_x];
+}
+
+// List a chunk's changed tiles in index order; returns how many there are
+int tile_edits_changes(const ChunkEdits *chunk, TileChange *changes)
+{
+  int count = 0;
+  for (int word = 0; word < (CHUNK_TILE_COUNT + 63) / 64; word++)
+  {
+    uint64_t bits = chunk->changed[word];
+    while (bits)
+    {
+      int index = word * 64 + __builtin_ctzll(bits);
+      changes[count].index = (unsigned char)index;
+      changes[count].tile_id = chunk->tile_ids[index];
+      count++;
+      bits &= bits - 1;
+    }
+  }
+  return count;
+}
+
+// Forget the edits once they have been broadcast
+void tile_edits_clear(TileEdits *edits)
+{
+  for (int i = 0; i < edits->dirty_count; i++)
+  {
+    ChunkEdits *chunk = &edits->dirty[i];
+    edits->pending[chunk->chunk_y * edits->chunks_x + chunk->chunk_x] = -1;
+  }
+  edits->dirty_count = 0;
+}
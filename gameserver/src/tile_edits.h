@@ -0,0 +1,40 @@
+#ifndef TILE_EDITS_H
+#define TILE_EDITS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "world.h"
+#include "../../common/src/chunk_codec.h"
+
+// Past this many changed tiles a chunk is cheaper to resend whole than as a delta
+#define TILE_DELTA_MAX_CHANGES (CHUNK_TILE_COUNT / 4)
+
+// Tiles of one chunk changed since the last flush. Editing the same tile
+// twice keeps only the last id.
+typedef struct {
+  int chunk_x;
+  int chunk_y;
+  uint64_t changed[(CHUNK_TILE_COUNT + 63) / 64]; // Bit per tile, row-major
+  unsigned char tile_ids[CHUNK_TILE_COUNT];
+} ChunkEdits;
+
+// Versions of every chunk plus the edits waiting to be broadcast. A chunk's
+// version goes up once per tick in which it changes, at the first edit, so
+// a chunk sent later in the same tick already carries the new version.
+typedef struct {
+  int chunks_x;
+  uint32_t *versions;   // Per chunk, row-major
+  int *pending;         // Per chunk, index into dirty or -1
+  ChunkEdits *dirty;    // Chunks edited since the last flush
+  int dirty_count;
+  int dirty_capacity;
+} TileEdits;
+
+bool tile_edits_init(TileEdits *edits, const World *world);
+void tile_edits_free(TileEdits *edits);
+bool tile_edits_set(TileEdits *edits, World *world, int x, int y, unsigned char tile_id);
+uint32_t tile_edits_version(const TileEdits *edits, int chunk_x, int chunk_y);
+int tile_edits_changes(const ChunkEdits *chunk, TileChange *changes);
+void tile_edits_clear(TileEdits *edits);
+
+#endif // TILE_EDITS_H
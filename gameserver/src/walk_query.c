@@ -0,0 +1,113 @@
+#include "walk_query.h"
+#include <limits.h>
+#include <stdlib.h>
+
+// Queries over the per-chunk walk masks. Chunk rows are spliced into 64-bit
+// words so a rectangle row or a vision row is tested a word at a time
+// rather than tile by tile. Anything outside the world counts as blocked.
+
+static int floor_div(int value, int divisor)
+{
+  return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+// Walkability of the 64 tiles starting at min_x in row y, bit i for tile min_x + i
+uint64_t walk_row_bits(const World *world, int min_x, int y)
+{
+  if (y < 0 || y >= world->height)
+  {
+    return 0;
+  }
+  uint64_t row = 0;
+  int chunk_y = y / CHUNK_SIZE;
+  int last = floor_div(min_x + 63, CHUNK_SIZE);
+  for (int chunk_x = floor_div(min_x, CHUNK_SIZE); chunk_x <= last; chunk_x++)
+  {
+    uint64_t bits = world_walk_mask(world, chunk_x, chunk_y)->rows[y % CHUNK_SIZE];
+    int offset = chunk_x * CHUNK_SIZE - min_x;
+    row |= offset >= 0 ? bits << offset : bits >> -offset;
+  }
+  return row;
+}
+
+// Bits for the first count tiles of a word
+static uint64_t low_bits(int count)
+{
+  return count >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << count) - 1;
+}
+
+// True if every tile of the inclusive rectangle is walkable
+bool walk_rect_clear(const World *world, int min_x, int min_y, int max_x, int max_y)
+{
+  if (min_x > max_x || min_y > max_y)
+  {
+    return false;
+  }
+  for (int y = min_y; y <= max_y; y++)
+  {
+    for (int x = min_x; x <= max_x; x += 64)
+    {
+      uint64_t need = low_bits(max_x - x + 1);
+      if ((walk_row_bits(world, x, y) & need) != need)
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// True if no blocked tile lies strictly between the two tiles. The line is
+// walked with Bresenham's algorithm, looking up a chunk's mask only when the
+// line crosses into it.
+bool walk_line_of_sight(const World *world, int from_x, int from_y, int to_x, int to_y)
+{
+  int dx = abs(to_x - from_x);
+  int dy = -abs(to_y - from_y);
+  int step_x = from_x < to_x ? 1 : -1;
+  int step_y = from_y < to_y ? 1 : -1;
+  int error = dx + dy;
+  int x = from_x;
+  int y = from_y;
+  int chunk_x = INT_MIN;
+  int chunk_y = INT_MIN;
+  const ChunkWalkMask *mask = NULL;
+
+  // The loop steps before it checks for the target
+  if (from_x == to_x && from_y == to_y)
+  {
+    return true;
+  }
+  for (;;)
+  {
+    int doubled = 2 * error;
+    if (doubled >= dy)
+    {
+      error += dy;
+      x += step_x;
+    }
+    if (doubled <= dx)
+    {
+      error += dx;
+      y += step_y;
+    }
+    if (x == to_x && y == to_y)
+    {
+      return true;
+    }
+    if (!world_in_bounds(world, x, y))
+    {
+      return false;
+    }
+    if (x / CHUNK_SIZE != chunk_x || y / CHUNK_SIZE != chunk_y)
+    {
+      chunk_x = x / CHUNK_SIZE;
+      chunk_y = y / CHUNK_SIZE;
+      mask = world_walk_mask(world, chunk_x, chunk_y);
+    }
+    if (!(mask->rows[y % CHUNK_SIZE] >> (x % CHUNK_SIZE) & 1))
+    {
+      return false;
+    }
+  }
+}
@@ -0,0 +1,12 @@
+#ifndef WALK_QUERY_H
+#define WALK_QUERY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "world.h"
+
+bool walk_rect_clear(const World *world, int min_x, int min_y, int max_x, int max_y);
+uint64_t walk_row_bits(const World *world, int min_x, int y);
+bool walk_line_of_sight(const World *world, int from_x, int from_y, int to_x, int to_y);
+
+#endif // WALK_QUERY_H
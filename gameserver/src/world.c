@@ -0,0 +1,182 @@
+#include "world.h"
+#include "../../common/src/log.h"
+#include <stdlib.h>
+
+// Set up an empty world; no chunk memory is allocated yet
+bool world_init(World *world, int width, int height)
+{
+  world->width = width;
+  world->height = height;
+  world->chunks_x = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  world->chunks_y = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  world->allocated = 0;
+  world->mapping = NULL;
+  world->mapping_size = 0;
+  world->chunks = calloc((size_t)world->chunks_x * world->chunks_y, sizeof(WorldChunk *));
+  world->walk_masks = calloc((size_t)world->chunks_x * world->chunks_y, sizeof(ChunkWalkMask *));
+  if (!world->chunks || !world->walk_masks)
+  {
+    LOG_ERROR("Failed to allocate chunk table for %dx%d world", width, height);
+    free(world->chunks);
+    free(world->walk_masks);
+    world->chunks = NULL;
+    world->walk_masks = NULL;
+    return false;
+  }
+  return true;
+}
+
+void world_free(World *world)
+{
+  if (!world->chunks)
+  {
+    return;
+  }
+  const char *mapping = world->mapping;
+  for (int i = 0; i < world->chunks_x * world->chunks_y; i++)
+  {
+    // Chunks that point into the map file are released with the mapping
+    const char *chunk = (const char *)world->chunks[i];
+    if (mapping && chunk >= mapping && chunk < mapping + world->mapping_size)
+    {
+      continue;
+    }
+    free(world->chunks[i]);
+  }
+  for (int i = 0; i < world->chunks_x * world->chunks_y; i++)
+  {
+    free(world->walk_masks[i]);
+  }
+  free(world->chunks);
+  free(world->walk_masks);
+  world->chunks = NULL;
+  world->walk_masks = NULL;
+  world->allocated = 0;
+}
+
+bool world_in_bounds(const World *world, int x, int y)
+{
+  return x >= 0 && x < world->width && y >= 0 && y < world->height;
+}
+
+bool world_chunk_in_bounds(const World *world, int chunk_x, int chunk_y)
+{
+  return chunk_x >= 0 && chunk_x < world->chunks_x && chunk_y >= 0 && chunk_y < world->chunks_y;
+}
+
+// Chunk holding the given chunk coordinates, NULL if it was never written
+const WorldChunk *world_get_chunk(const World *world, int chunk_x, int chunk_y)
+{
+  if (!world_chunk_in_bounds(world, chunk_x, chunk_y))
+  {
+    return NULL;
+  }
+  return world->chunks[chunk_y * world->chunks_x + chunk_x];
+}
+
+// Read a tile; anything outside the map or in an empty chunk is void
+Tile world_get_tile(const World *world, int x, int y)
+{
+  Tile empty = {0, false};
+  if (!world_in_bounds(world, x, y))
+  {
+    return empty;
+  }
+  const WorldChunk *chunk = world_get_chunk(world, x / CHUNK_SIZE, y / CHUNK_SIZE);
+  if (!chunk)
+  {
+    return empty;
+  }
+  return chunk->tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE];
+}
+
+// Write a tile, allocating its chunk on first use
+bool world_set_tile(World *world, int x, int y, Tile tile)
+{
+  if (!world_in_bounds(world, x, y))
+  {
+    return false;
+  }
+  WorldChunk **slot = &world->chunks[(y / CHUNK_SIZE) * world->chunks_x + x / CHUNK_SIZE];
+  if (!*slot)
+  {
+    *slot = calloc(1, sizeof(WorldChunk));
+    if (!*slot)
+    {
+      LOG_ERROR("Failed to allocate chunk for tile (%d, %d)", x, y);
+      return false;
+    }
+    world->allocated++;
+  }
+  (*slot)->tiles[(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE] = tile;
+
+  ChunkWalkMask *mask = world->walk_masks[(y / CHUNK_SIZE) * world->chunks_x + x / CHUNK_SIZE];
+  if (mask)
+  {
+    uint16_t bit = (uint16_t)(1u << (x % CHUNK_SIZE));
+    if (tile.walkable)
+    {
+      mask->rows[y % CHUNK_SIZE] |= bit;
+    }
+    else
+    {
+      mask->rows[y % CHUNK_SIZE] &= (uint16_t)~bit;
+    }
+  }
+  return true;
+}
+
+bool world_is_walkable(const World *world, int x, int y)
+{
+  return world_get_tile(world, x, y).walkable;
+}
+
+// Walkability bits of a chunk. Masks are built the first time they are asked
+// for, so a mapped map file is only paged in where it is queried. Building
+// may race between threads; the first mask published wins.
+const ChunkWalkMask *world_walk_mask(const World *world, int chunk_x, int chunk_y)
+{
+  static const ChunkWalkMask blocked = {{0}};
+  const WorldChunk *chunk = world_get_chunk(world, chunk_x, chunk_y);
+  if (!chunk)
+  {
+    return &blocked;
+  }
+  ChunkWalkMask **slot = &world->walk_masks[chunk_y * world->chunks_x + chunk_x];
+  ChunkWalkMask *mask = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+  if (mask)
+  {
+    return mask;
+  }
+
+  mask = calloc(1, sizeof(ChunkWalkMask));
+  if (!mask)
+  {
+    LOG_ERROR("Failed to allocate walk mask for chunk (%d, %d)", chunk_x, chunk_y);
+    return &blocked;
+  }
+  // Tiles past the edge of the world stay blocked
+  int width = world->width - chunk_x * CHUNK_SIZE;
+  int height = world->height - chunk_y * CHUNK_SIZE;
+  width = width < CHUNK_SIZE ? width : CHUNK_SIZE;
+  height = height < CHUNK_SIZE ? height : CHUNK_SIZE;
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      if (chunk->tiles[y * CHUNK_SIZE + x].walkable)
+      {
+        mask->rows[y] |= (uint16_t)(1u << x);
+      }
+    }
+  }
+
+  ChunkWalkMask *expected = NULL;
+  if (!__atomic_compare_exchange_n(slot, &expected, mask, false, __ATOMIC_ACQ_REL,
+                                   __ATOMIC_ACQUIRE))
+  {
+    free(mask);
+    return expected;
+  }
+  return mask;
+}
@@ -0,0 +1,44 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../../common/src/common.h"
+
+// A square block of tiles, stored row-major
+typedef struct {
+  Tile tiles[CHUNK_SIZE * CHUNK_SIZE];
+} WorldChunk;
+
+// Walkability of one chunk, one bit per tile: bit x of rows[y] is tile (x, y)
+typedef struct {
+  uint16_t rows[CHUNK_SIZE];
+} ChunkWalkMask;
+_Static_assert(CHUNK_SIZE <= 16, "chunk walk mask rows hold 16 tiles");
+
+// Chunked tile store of arbitrary size. Chunks are allocated the first time a
+// tile inside them is written; unallocated chunks read as void tiles.
+typedef struct {
+  int width;          // Size in tiles
+  int height;
+  int chunks_x;       // Size in chunks
+  int chunks_y;
+  int allocated;      // Number of chunks currently allocated
+  WorldChunk **chunks;
+  ChunkWalkMask **walk_masks; // Built from the tiles on first use, then kept in sync
+  void *mapping;      // Map file backing some chunks, see mapfile.h
+  size_t mapping_size;
+} World;
+
+bool world_init(World *world, int width, int height);
+void world_free(World *world);
+bool world_in_bounds(const World *world, int x, int y);
+bool world_chunk_in_bounds(const World *world, int chunk_x, int chunk_y);
+Tile world_get_tile(const World *world, int x, int y);
+bool world_set_tile(World *world, int x, int y, Tile tile);
+bool world_is_walkable(const World *world, int x, int y);
+const WorldChunk *world_get_chunk(const World *world, int chunk_x, int chunk_y);
+const ChunkWalkMask *world_walk_mask(const World *world, int chunk_x, int chunk_y);
+
+#endif // WORLD_H
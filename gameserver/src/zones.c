@@ -0,0 +1,290 @@
+#include "zones.h"
+#include "../../common/src/log.h"
+#include <stdlib.h>
+
+typedef struct {
+  ZoneSet *set;
+  Zone *zone;
+} ZoneWorker;
+
+static ZoneWorker workers[MAX_ZONES];
+
+// Zone owning a tile column
+static int zone_for_x(const ZoneSet *set, int x)
+{
+  for (int i = 0; i < set->count - 1; i++)
+  {
+    if (x < set->zones[i].max_x)
+    {
+      return i;
+    }
+  }
+  return set->count - 1;
+}
+
+static void zone_remove_owned(Zone *zone, int id)
+{
+  for (int i = 0; i < zone->owned_count; i++)
+  {
+    if (zone->owned[i] == id)
+    {
+      zone->owned[i] = zone->owned[--zone->owned_count];
+      break;
+    }
+  }
+  spatial_grid_remove(&zone->grid, id);
+}
+
+static void zone_insert_owned(Zone *zone, int id, int x, int y)
+{
+  zone->owned[zone->owned_count++] = id;
+  spatial_grid_insert(&zone->grid, id, x, y);
+}
+
+// Wait for each run of the set and do this zone's share of it
+static void *zone_worker_main(void *arg)
+{
+  ZoneWorker *worker = arg;
+  ZoneSet *set = worker->set;
+  uint32_t seen = 0;
+
+  pthread_mutex_lock(&set->lock);
+  for (;;)
+  {
+    while (set->generation == seen && !set->stopping)
+    {
+      pthread_cond_wait(&set->work_ready, &set->lock);
+    }
+    if (set->stopping)
+    {
+      break;
+    }
+    seen = set->generation;
+    ZoneWork work = set->work;
+    void *context = set->context;
+    pthread_mutex_unlock(&set->lock);
+
+    work(set, worker->zone, context);
+
+    pthread_mutex_lock(&set->lock);
+    if (--set->pending == 0)
+    {
+      pthread_cond_signal(&set->work_done);
+    }
+  }
+  pthread_mutex_unlock(&set->lock);
+  return NULL;
+}
+
+// Split the world into count strips of columns and start one worker per
+// strip. Strips are kept at least as wide as the ghost margin so ghosts only
+// ever come from the two adjacent zones.
+bool zone_set_init(ZoneSet *set, int count, int world_width, int world_height, int margin,
+                   ServerPlayerMap *map)
+{
+  if (count > MAX_ZONES)
+  {
+    count = MAX_ZONES;
+  }
+  if (margin > 0 && count > world_width / margin)
+  {
+    count = world_width / margin;
+    LOG_WARN("Map is too narrow for more than %d zones", count);
+  }
+  set->count = 0;
+  if (count < 2)
+  {
+    return true;
+  }
+
+  set->margin = margin;
+  set->map = map;
+  set->generation = 0;
+  set->pending = 0;
+  set->stopping = false;
+  set->zone_of = malloc(sizeof(int) * map->capacity);
+  if (!set->zone_of)
+  {
+    LOG_ERROR("Failed to allocate zones");
+    return false;
+  }
+  for (int i = 0; i < map->capacity; i++)
+  {
+    set->zone_of[i] = -1;
+  }
+  pthread_mutex_init(&set->lock, NULL);
+  pthread_cond_init(&set->work_ready, NULL);
+  pthread_cond_init(&set->work_done, NULL);
+
+  int width = (world_width + count - 1) / count;
+  for (int i = 0; i < count; i++)
+  {
+    Zone *zone = &set->zones[i];
+    zone->index = i;
+    zone->min_x = i * width;
+    zone->max_x = i == count - 1 ? world_width : (i + 1) * width;
+    zone->owned_count = 0;
+    zone->ghost_count = 0;
+    zone->owned = malloc(sizeof(int) * map->capacity);
+    zone->ghosts = malloc(sizeof(int) * map->capacity);
+    if (!zone->owned || !zone->ghosts ||
+        !spatial_grid_init(&zone->grid, world_width, world_height, GRID_CELL_SIZE, map->capacity))
+    {
+      LOG_ERROR("Failed to allocate zone %d", i);
+      free(zone->owned);
+      free(zone->ghosts);
+      zone_set_shutdown(set);
+      return false;
+    }
+    workers[i].set = set;
+    workers[i].zone = zone;
+    if (pthread_create(&zone->thread, NULL, zone_worker_main, &workers[i]) != 0)
+    {
+      LOG_ERROR("Failed to start worker for zone %d", i);
+      spatial_grid_free(&zone->grid);
+      free(zone->owned);
+      free(zone->ghosts);
+      zone_set_shutdown(set);
+      return false;
+    }
+    set->count++;
+  }
+  LOG_INFO("Simulating %d zones of %d columns with a %d tile ghost margin", count, width,
+           margin);
+  return true;
+}
+
+// Stop the workers and free the zones
+void zone_set_shutdown(ZoneSet *set)
+{
+  if (set->count == 0)
+  {
+    free(set->zone_of);
+    set->zone_of = NULL;
+    return;
+  }
+  pthread_mutex_lock(&set->lock);
+  set->stopping = true;
+  pthread_cond_broadcast(&set->work_ready);
+  pthread_mutex_unlock(&set->lock);
+
+  for (int i = 0; i < set->count; i++)
+  {
+    pthread_join(set->zones[i].thread, NULL);
+    spatial_grid_free(&set->zones[i].grid);
+    free(set->zones[i].owned);
+    free(set->zones[i].ghosts);
+  }
+  free(set->zone_of);
+  set->zone_of = NULL;
+  pthread_cond_destroy(&set->work_done);
+  pthread_cond_destroy(&set->work_ready);
+  pthread_mutex_destroy(&set->lock);
+  set->count = 0;
+}
+
+// Run work on every zone in parallel and return once all of them finished.
+// The work may only write to its own zone and the players it owns.
+void zone_set_run(ZoneSet *set, ZoneWork work, void *context)
+{
+  pthread_mutex_lock(&set->lock);
+  set->work = work;
+  set->context = context;
+  set->pending = set->count;
+  set->generation++;
+  pthread_cond_broadcast(&set->work_ready);
+  while (set->pending > 0)
+  {
+    pthread_cond_wait(&set->work_done, &set->lock);
+  }
+  pthread_mutex_unlock(&set->lock);
+}
+
+// Give a new player to the zone it stands in
+void zone_set_add(ZoneSet *set, int id, int x, int y)
+{
+  int index = zone_for_x(set, x);
+  set->zone_of[id] = index;
+  zone_insert_owned(&set->zones[index], id, x, y);
+}
+
+void zone_set_remove(ZoneSet *set, int id)
+{
+  int index = set->zone_of[id];
+  if (index < 0)
+  {
+    return;
+  }
+  zone_remove_owned(&set->zones[index], id);
+  set->zone_of[id] = -1;
+}
+
+// Move players that walked out of their zone to the zone they are in now.
+// Runs between parallel phases, when no worker is touching the zones.
+void zone_set_handoff(ZoneSet *set)
+{
+  for (int i = 0; i < set->count; i++)
+  {
+    Zone *zone = &set->zones[i];
+    for (int j = 0; j < zone->owned_count; j++)
+    {
+      int id = zone->owned[j];
+      const Player *player = &set->map->entries[id].player;
+      if (player->x >= zone->min_x && player->x < zone->max_x)
+      {
+        continue;
+      }
+      int target = zone_for_x(set, player->x);
+      zone_remove_owned(zone, id);
+      zone_insert_owned(&set->zones[target], id, player->x, player->y);
+      set->zone_of[id] = target;
+      LOG_TRACE("Player %d handed off from zone %d to zone %d", id, i, target);
+      // The last owned id was swapped into this position
+      j--;
+    }
+  }
+}
+
+// Replace a zone's ghosts with the current neighbor players near its border.
+// Only reads the neighbors' owned lists and player positions, so every zone
+// can refresh in parallel once simulation and handoff are done.
+void zone_refresh_ghosts(ZoneSet *set, Zone *zone)
+{
+  for (int i = 0; i < zone->ghost_count; i++)
+  {
+    // A ghost may have walked into this zone since and be owned now
+    if (set->zone_of[zone->ghosts[i]] != zone->index)
+    {
+      spatial_grid_remove(&zone->grid, zone->ghosts[i]);
+    }
+  }
+  zone->ghost_count = 0;
+
+  int min_x = zone->min_x - set->margin;
+  int max_x = zone->max_x - 1 + set->margin;
+  for (int n = zone->index - 1; n <= zone->index + 1; n += 2)
+  {
+    if (n < 0 || n >= set->count)
+    {
+      continue;
+    }
+    const Zone *neighbor = &set->zones[n];
+    for (int i = 0; i < neighbor->owned_count; i++)
+    {
+      int id = neighbor->owned[i];
+      const Player *player = &set->map->entries[id].player;
+      if (player->x >= min_x && player->x <= max_x)
+      {
+        zone->ghosts[zone->ghost_count++] = id;
+        spatial_grid_insert(&zone->grid, id, player->x, player->y);
+      }
+    }
+  }
+}
+
+// Grid of the zone owning a tile column. With its ghosts it answers queries
+// up to the ghost margin away from that column exactly.
+const SpatialGrid *zone_set_grid_at(const ZoneSet *set, int x)
+{
+  return &set->zones[zone_for_x(set, x)].grid;
+}
@@ -0,0 +1,58 @@
+#ifndef ZONES_H
+#define ZONES_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "player_map.h"
+#include "spatial_grid.h"
+
+#define MAX_ZONES 16
+
+// Vertical strip of the world simulated by one worker thread. The zone owns
+// the players standing in its columns; players of the neighboring zones
+// within the ghost margin of its border are copied in read-only so queries
+// near the border see the same players as a query on the whole world.
+typedef struct {
+  int index;
+  int min_x;                 // First tile column owned
+  int max_x;                 // One past the last tile column owned
+  SpatialGrid grid;          // Owned players and ghosts
+  int *owned;                // Player ids, up to the map's capacity
+  int owned_count;
+  int *ghosts;
+  int ghost_count;
+  pthread_t thread;
+} Zone;
+
+typedef struct ZoneSet ZoneSet;
+typedef void (*ZoneWork)(ZoneSet *set, Zone *zone, void *context);
+
+struct ZoneSet {
+  Zone zones[MAX_ZONES];
+  int count;                 // 0 when zones are disabled
+  int margin;                // Ghost border width in tiles
+  int *zone_of;              // Owning zone of each player id, -1 if none
+  ServerPlayerMap *map;
+  // Worker hand-off: each run bumps the generation and waits for pending == 0
+  pthread_mutex_t lock;
+  pthread_cond_t work_ready;
+  pthread_cond_t work_done;
+  uint32_t generation;
+  int pending;
+  bool stopping;
+  ZoneWork work;
+  void *context;
+};
+
+bool zone_set_init(ZoneSet *set, int count, int world_width, int world_height, int margin,
+                   ServerPlayerMap *map);
+void zone_set_shutdown(ZoneSet *set);
+void zone_set_run(ZoneSet *set, ZoneWork work, void *context);
+void zone_set_add(ZoneSet *set, int id, int x, int y);
+void zone_set_remove(ZoneSet *set, int id);
+void zone_set_handoff(ZoneSet *set);
+void zone_refresh_ghosts(ZoneSet *set, Zone *zone);
+const SpatialGrid *zone_set_grid_at(const ZoneSet *set, int x);
+
+#endif // ZONES_H
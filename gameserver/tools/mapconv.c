@@ -0,0 +1,37 @@
+// Offline converter from text maps to the binary map format
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/mapfile.h"
+
+int main(int argc, char *argv[])
+{
+  if (argc != 3)
+  {
+    printf("Usage: %s <map.txt> <map.bin>\n", argv[0]);
+    return 1;
+  }
+
+  World world;
+  if (!map_load_text(&world, argv[1]))
+  {
+    return 1;
+  }
+  if (!map_save_binary(&world, argv[2]))
+  {
+    world_free(&world);
+    return 1;
+  }
+  printf("Converted %s to %s: %dx%d tiles, %d chunks of %dx%d\n", argv[1], argv[2],
+         world.width, world.height, world.allocated, CHUNK_SIZE, CHUNK_SIZE);
+  world_free(&world);
+
+  // Read the result back so a bad conversion is caught here and not at server start
+  World check = {0};
+  if (!map_load_binary(&check, argv[2]))
+  {
+    printf("Verification of %s failed\n", argv[2]);
+    return 1;
+  }
+  map_unload(&check);
+  return 0;
+}